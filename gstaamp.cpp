@@ -25,20 +25,103 @@
 #include <string.h>
 #include <stdio.h>
 #include "gstaamp.h"
+#include "gstaampfragment.h"
+#include "gstaampcache.h"
+#include "gstaamptimeshift.h"
 #include "main_aamp.h"
 #include "priv_aamp.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_aamp_debug_category);
 #define GST_CAT_DEFAULT gst_aamp_debug_category
 
+/* Default chunk size for MPEG-TS, other containers are chunked on their own structure */
 #define MAX_BYTES_TO_SEND (188*1024)
 
+/* Buffers pre-allocated by a src pad pool on activation and the cap on buffers
+ * it keeps for reuse. Acquiring beyond the cap falls back to a plain allocation. */
+#define AAMP_BUFFER_POOL_MIN_BUFFERS 4
+#define AAMP_BUFFER_POOL_MAX_BUFFERS 64
+
+/* Default number of buffers, buffer lists or events queued per src pad in async-push mode */
+#define AAMP_DEFAULT_RING_DEPTH 32
+
+/* Events a src pad sends before its next buffer, or-ed into media_stream::pendingEvents
+ * by any thread and taken in one atomic exchange by SendPendingEvents() */
+#define AAMP_EVENT_STREAM_START    (1 << 0)
+#define AAMP_EVENT_FLUSH           (1 << 1)
+#define AAMP_EVENT_RESET_POSITION  (1 << 2)
+#define AAMP_EVENT_REPLAY          (1 << 3)
+
+/* How often a Send() held back by the in-flight budget re-checks playback progress */
+#define AAMP_BUDGET_POLL_INTERVAL_US (20 * 1000)
+/* Longest a track is held back waiting for the other one to catch up */
+#define AAMP_INTERLEAVE_MAX_WAIT_US (2 * G_USEC_PER_SEC)
+
+/* Standby instances kept by default (channel up, down and last) and the fragments
+ * each one buffers before its fetcher waits for an element to take it over */
+#define AAMP_STANDBY_DEFAULT_SIZE 3
+#define AAMP_STANDBY_STARTUP_QUEUE_BYTES (4*1024*1024)
+
 #define  GST_AAMP_LOG_TIMING(msg...) GST_FIXME_OBJECT(aamp, msg)
 
+/* Field names of the tune milestones in the aamp-tune-times structure */
+static const gchar *gst_aamp_tune_milestone_names[GST_AAMP_TUNE_MILESTONE_COUNT] =
+{
+	"start", "tune", "configure", "pads-exposed", "first-video-buffer", "first-audio-buffer", "discont-cleared", "playing"
+};
+
+/**
+ * @brief Timestamp a tune milestone the first time it is reached, TRUE for that first time
+ *
+ * Some milestones are reached on the fetch threads of both tracks, the first one wins. The
+ * times are stored under the mutex, the atomic check keeps the push path cheap once set.
+ * Called without the mutex.
+ */
+static inline gboolean gst_aamp_tune_mark(GstAamp * aamp, GstAampTuneMilestone milestone)
+{
+	guint bit = 1u << milestone;
+	if (G_LIKELY(g_atomic_int_get(&aamp->tune_marked) & bit))
+	{
+		return FALSE;
+	}
+	gint64 now = g_get_monotonic_time();
+	g_mutex_lock(&aamp->mutex);
+	gboolean first = !(aamp->tune_marked & bit);
+	if (first)
+	{
+		aamp->tune_times[milestone] = now;
+		g_atomic_int_or(&aamp->tune_marked, bit);
+	}
+	g_mutex_unlock(&aamp->mutex);
+	if (first)
+	{
+		GST_AAMP_LOG_TIMING("tune milestone %s", gst_aamp_tune_milestone_names[milestone]);
+	}
+	return first;
+}
+
+/**
+ * @brief Forget the milestones of the previous tune, called without the mutex
+ */
+static void gst_aamp_tune_reset(GstAamp * aamp)
+{
+	g_mutex_lock(&aamp->mutex);
+	memset(aamp->tune_times, 0, sizeof(aamp->tune_times));
+	g_atomic_int_and(&aamp->tune_marked, 0);
+	if (aamp->tune_stats)
+	{
+		gst_structure_free(aamp->tune_stats);
+		aamp->tune_stats = NULL;
+	}
+	g_mutex_unlock(&aamp->mutex);
+}
+
 static const gchar *g_aamp_expose_hls_caps = NULL;
 
 static GstStateChangeReturn
 gst_aamp_change_state(GstElement * element, GstStateChange transition);
+static void gst_aamp_set_property(GObject * object, guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_aamp_get_property(GObject * object, guint property_id, GValue * value, GParamSpec * pspec);
 static void gst_aamp_finalize(GObject * object);
 static gboolean gst_aamp_query(GstElement * element, GstQuery * query);
 
@@ -49,7 +132,16 @@ static gboolean gst_aamp_src_event(GstPad * pad, GstObject *parent, GstEvent * e
 static gboolean gst_aamp_src_query(GstPad * pad, GstObject *parent, GstQuery * query);
 
 static void gst_aamp_configure(GstAamp * aamp, StreamOutputFormat format, StreamOutputFormat audioFormat);
+static gsize gst_aamp_get_max_chunk_size(GstAamp * aamp, StreamOutputFormat format);
 static gboolean gst_aamp_ready(GstAamp *aamp);
+static void gst_aamp_set_buffer_release_func(GstAamp *aamp, gpointer func, gpointer user_data);
+static void gst_aamp_tune_done(GstAamp * aamp);
+static void gst_aamp_standby_add(GstAamp *element, const gchar *uri);
+static void gst_aamp_standby_remove(GstAamp *element, const gchar *uri);
+static void gst_aamp_standby_set_size(GstAamp *element, guint size);
+#ifdef USE_GST1
+static void gst_aamp_decide_allocation(GstAamp * aamp, media_stream * stream);
+#endif
 
 #ifdef AAMP_JSCONTROLLER_ENABLED
 extern "C"
@@ -61,151 +153,824 @@ extern "C"
 
 enum
 {
-	PROP_0
+	PROP_0,
+	PROP_POOL_STATS,
+	PROP_PUSH_BUFFER_LIST,
+	PROP_CHUNK_SIZE,
+	PROP_ASYNC_PUSH,
+	PROP_RING_DEPTH,
+	PROP_RING_STATS,
+	PROP_MAX_INFLIGHT_BYTES,
+	PROP_MAX_INFLIGHT_TIME,
+	PROP_SPLIT_ACCESS_UNITS,
+	PROP_INTERLEAVE_WINDOW,
+	PROP_SEEK_CACHE_TIME,
+	PROP_SEEK_CACHE_BYTES,
+	PROP_TIMESHIFT_SIZE,
+	PROP_TIMESHIFT_LOCATION,
+	PROP_KEEP_AUDIO_PAD,
+	PROP_STARTUP_QUEUE_BYTES,
+	PROP_LOCATION,
+	PROP_TUNE_TIMES,
+	PROP_STATS
 };
 
-class GstAampStreamer : public StreamSink, public AAMPEventListener
+enum
 {
-public:
-	GstAampStreamer(GstAamp * aamp)
+	SIGNAL_SET_BUFFER_RELEASE_FUNC,
+	SIGNAL_STANDBY_ADD,
+	SIGNAL_STANDBY_REMOVE,
+	SIGNAL_STANDBY_SET_SIZE,
+	LAST_SIGNAL
+};
+
+static guint gst_aamp_signals[LAST_SIGNAL] = { 0 };
+
+/**
+ * @brief Tracks the buffers wrapping one zero-copy fragment
+ */
+struct GstAampFragmentRef
+{
+	const void *ptr;
+	gint refcount;
+	GstAampBufferReleaseFunc func;
+	gpointer user_data;
+};
+
+static void gst_aamp_fragment_ref_release(gpointer data)
+{
+	GstAampFragmentRef *ref = (GstAampFragmentRef *) data;
+	if (g_atomic_int_dec_and_test(&ref->refcount))
 	{
-		this->aamp = aamp;
-		rate = 1.0;
-		srcPadCapsSent = true;
-		format = FORMAT_INVALID;
-		audioFormat = FORMAT_NONE;
-		readyToSend = false;
-		gst_segment_init(&segment, GST_FORMAT_TIME);
+		ref->func(ref->ptr, ref->user_data);
+		g_slice_free(GstAampFragmentRef, ref);
 	}
+}
 
-	void Configure(StreamOutputFormat format, StreamOutputFormat audioFormat)
+/**
+ * @brief A fragment that arrived before the src pads were ready, in memory it owns
+ */
+struct GstAampStartupFragment
+{
+	gpointer data;
+	gsize len;
+	double fpts;
+	double fdts;
+	double fDuration;
+};
+
+/* Release function of fragments in memory the element owns */
+static void gst_aamp_owned_fragment_release(const void *ptr, gpointer user_data)
+{
+	g_free((gpointer) ptr);
+}
+
+/**
+ * @brief Bounded single-producer/single-consumer queue feeding a src pad task
+ *
+ * The thread holding the send mutex of the stream is the only producer and the pad
+ * task the only consumer. Slots are handed over through the atomic head and tail counters, the
+ * mutex is only taken to sleep on a full or empty ring and to wake the sleeper.
+ */
+struct GstAampRing
+{
+	GstMiniObject **items;
+	guint depth;
+	gint head;
+	gint tail;
+	gint flushing;
+	gint stopped;
+	gint producerWaiting;
+	gint consumerWaiting;
+	gint64 blockedTime;
+	GMutex mutex;
+	GCond cond;
+};
+
+static GstAampRing* gst_aamp_ring_new(guint depth)
+{
+	GstAampRing *ring = g_slice_new0(GstAampRing);
+	ring->items = g_new0(GstMiniObject*, depth);
+	ring->depth = depth;
+	g_mutex_init(&ring->mutex);
+	g_cond_init(&ring->cond);
+	return ring;
+}
+
+static void gst_aamp_ring_clear(GstAampRing *ring)
+{
+	guint head = (guint) g_atomic_int_get(&ring->head);
+	guint tail = (guint) g_atomic_int_get(&ring->tail);
+	for (; head != tail; head++)
 	{
-		GST_INFO_OBJECT(aamp, "Enter format = %d audioFormat = %d", format, audioFormat);
-		this->format = format;
-		this->audioFormat = audioFormat;
-		gst_aamp_configure(aamp, format, audioFormat);
+		gst_mini_object_unref(ring->items[head % ring->depth]);
+		ring->items[head % ring->depth] = NULL;
 	}
+	g_atomic_int_set(&ring->head, (gint) head);
+}
 
-	void SendPendingEvents(media_stream* stream, GstClockTime pts)
+/**
+ * @brief Drop the queued items from outside the pad task, while it is paused
+ *
+ * Sticky events other than segment and EOS are stored on the pad instead, which sends
+ * them ahead of the next data, so a flush does not lose the stream start and caps.
+ */
+static void gst_aamp_ring_drop(GstAampRing *ring, GstPad *pad)
+{
+	guint head = (guint) g_atomic_int_get(&ring->head);
+	guint tail = (guint) g_atomic_int_get(&ring->tail);
+	for (; head != tail; head++)
 	{
-		if (stream->streamStart)
+		GstMiniObject *item = ring->items[head % ring->depth];
+		ring->items[head % ring->depth] = NULL;
+#ifdef USE_GST1
+		if (GST_IS_EVENT(item) && GST_EVENT_IS_STICKY(GST_EVENT_CAST(item))
+				&& (GST_EVENT_TYPE(item) != GST_EVENT_SEGMENT) && (GST_EVENT_TYPE(item) != GST_EVENT_EOS))
 		{
-			GST_INFO_OBJECT(aamp, "sending new_stream_start\n");
-			gboolean ret = gst_pad_push_event(stream->srcpad, gst_event_new_stream_start(aamp->stream_id));
-			if (!ret)
-			{
-				GST_ERROR_OBJECT(aamp, "%s: stream start error\n", __FUNCTION__);
-
-			}
-			GST_INFO_OBJECT(aamp, "%s: sending caps\n", __FUNCTION__);
-			ret = gst_pad_push_event(stream->srcpad, gst_event_new_caps(stream->caps));
-			if (!ret)
-			{
-				GST_ERROR_OBJECT(aamp, "%s: caps evt error\n", __FUNCTION__);
-			}
-			stream->streamStart = FALSE;
+			gst_pad_store_sticky_event(pad, GST_EVENT_CAST(item));
 		}
-		if (stream->flush)
-		{
-			gboolean ret = gst_pad_push_event(stream->srcpad, gst_event_new_flush_start());
-			if (!ret)
-			{
-				GST_ERROR_OBJECT(aamp, "%s: flush start error\n", __FUNCTION__);
-			}
-#ifdef USE_GST1
-			GstEvent* event = gst_event_new_flush_stop(FALSE);
-#else
-			GstEvent* event = gst_event_new_flush_stop();
 #endif
-			ret = gst_pad_push_event(stream->srcpad, event);
-			if (!ret)
-			{
-				GST_ERROR_OBJECT(aamp, "%s: flush stop error\n", __FUNCTION__);
-			}
-			stream->flush = FALSE;
+		gst_mini_object_unref(item);
+	}
+	g_atomic_int_set(&ring->head, (gint) head);
+}
+
+static void gst_aamp_ring_free(GstAampRing *ring)
+{
+	gst_aamp_ring_clear(ring);
+	g_free(ring->items);
+	g_mutex_clear(&ring->mutex);
+	g_cond_clear(&ring->cond);
+	g_slice_free(GstAampRing, ring);
+}
+
+static void gst_aamp_ring_wake(GstAampRing *ring)
+{
+	g_mutex_lock(&ring->mutex);
+	g_cond_broadcast(&ring->cond);
+	g_mutex_unlock(&ring->mutex);
+}
+
+/**
+ * @brief Wake both ends and make them give up; leaving flushing drops stale items
+ */
+static void gst_aamp_ring_set_flushing(GstAampRing *ring, gboolean flushing)
+{
+	if (!flushing)
+	{
+		gst_aamp_ring_clear(ring);
+	}
+	g_atomic_int_set(&ring->flushing, flushing);
+	gst_aamp_ring_wake(ring);
+}
+
+/**
+ * @brief Stop the ring with its pad task, or restart it empty. Unlike a flush, which
+ * ends on its own, a stop lasts until the task is started again.
+ */
+static void gst_aamp_ring_set_stopped(GstAampRing *ring, gboolean stopped)
+{
+	if (!stopped)
+	{
+		gst_aamp_ring_clear(ring);
+		g_atomic_int_set(&ring->flushing, FALSE);
+	}
+	g_atomic_int_set(&ring->stopped, stopped);
+	gst_aamp_ring_wake(ring);
+}
+
+static gboolean gst_aamp_ring_is_flushing(GstAampRing *ring)
+{
+	return g_atomic_int_get(&ring->flushing) || g_atomic_int_get(&ring->stopped);
+}
+
+static guint gst_aamp_ring_level(GstAampRing *ring)
+{
+	return (guint) g_atomic_int_get(&ring->tail) - (guint) g_atomic_int_get(&ring->head);
+}
+
+/**
+ * @brief Queue an item, blocking while the ring is full. Takes ownership of item.
+ */
+static gboolean gst_aamp_ring_push(GstAampRing *ring, GstMiniObject *item)
+{
+	guint tail = (guint) g_atomic_int_get(&ring->tail);
+	if (gst_aamp_ring_level(ring) >= ring->depth)
+	{
+		gint64 start = g_get_monotonic_time();
+		g_mutex_lock(&ring->mutex);
+		g_atomic_int_set(&ring->producerWaiting, 1);
+		while (!gst_aamp_ring_is_flushing(ring) && (gst_aamp_ring_level(ring) >= ring->depth))
+		{
+			g_cond_wait(&ring->cond, &ring->mutex);
 		}
-		if (stream->resetPosition)
+		g_atomic_int_set(&ring->producerWaiting, 0);
+		ring->blockedTime += g_get_monotonic_time() - start;
+		g_mutex_unlock(&ring->mutex);
+	}
+	if (gst_aamp_ring_is_flushing(ring))
+	{
+		gst_mini_object_unref(item);
+		return FALSE;
+	}
+	ring->items[tail % ring->depth] = item;
+	g_atomic_int_set(&ring->tail, (gint) (tail + 1));
+	if (g_atomic_int_get(&ring->consumerWaiting))
+	{
+		gst_aamp_ring_wake(ring);
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Take the oldest item, blocking while the ring is empty. NULL when flushing.
+ */
+static GstMiniObject* gst_aamp_ring_pop(GstAampRing *ring)
+{
+	guint head = (guint) g_atomic_int_get(&ring->head);
+	if (head == (guint) g_atomic_int_get(&ring->tail))
+	{
+		g_mutex_lock(&ring->mutex);
+		g_atomic_int_set(&ring->consumerWaiting, 1);
+		while (!gst_aamp_ring_is_flushing(ring) && (head == (guint) g_atomic_int_get(&ring->tail)))
 		{
+			g_cond_wait(&ring->cond, &ring->mutex);
+		}
+		g_atomic_int_set(&ring->consumerWaiting, 0);
+		g_mutex_unlock(&ring->mutex);
+	}
+	if (gst_aamp_ring_is_flushing(ring))
+	{
+		return NULL;
+	}
+	GstMiniObject *item = ring->items[head % ring->depth];
+	ring->items[head % ring->depth] = NULL;
+	g_atomic_int_set(&ring->head, (gint) (head + 1));
+	if (g_atomic_int_get(&ring->producerWaiting))
+	{
+		gst_aamp_ring_wake(ring);
+	}
+	return item;
+}
+
+/**
+ * @brief Count a buffer about to be pushed, its size and pts are added up by the caller
+ */
+static void gst_aamp_stats_count_buffer(GstAampPadStats *stats, GstBuffer *buffer, guint64 *bytes, GstClockTime *lastPts)
+{
+	g_atomic_int_inc(&stats->buffers);
+	if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT))
+	{
+		g_atomic_int_inc(&stats->discontinuities);
+	}
 #ifdef USE_GST1
-			GstSegment segment;
-			gst_segment_init(&segment, GST_FORMAT_TIME);
-			segment.start = pts;
-			segment.position = 0;
-			segment.rate = 1.0;
-			segment.applied_rate = rate;
-			GST_INFO_OBJECT(aamp, "Sending segment event. start %" G_GUINT64_FORMAT " stop %" G_GUINT64_FORMAT " rate %f\n", segment.start, segment.stop, segment.rate);
-			GstEvent* event = gst_event_new_segment (&segment);
+	GstClockTime pts = GST_BUFFER_PTS(buffer);
+	*bytes += gst_buffer_get_size(buffer);
 #else
-			GstEvent* event = gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, pts, GST_CLOCK_TIME_NONE, 0);
+	GstClockTime pts = GST_BUFFER_TIMESTAMP(buffer);
+	*bytes += GST_BUFFER_SIZE(buffer);
 #endif
-			if (!gst_pad_push_event(stream->srcpad, event))
-			{
-				GST_ERROR_OBJECT(aamp, "%s: gst_pad_push_event segment error\n", __FUNCTION__);
-			}
-			stream->resetPosition = FALSE;
-		}
-		stream->eventsPending = FALSE;
+	if (GST_CLOCK_TIME_IS_VALID(pts))
+	{
+		*lastPts = pts;
 	}
+}
 
-	void Send(MediaType mediaType, const void *ptr, size_t len0, double fpts, double fdts, double fDuration)
+/**
+ * @brief Count the outcome of a push call, the 64-bit counters once per call under the lock
+ */
+static void gst_aamp_stats_count_flow(GstAampPadStats *stats, guint64 bytes, GstClockTime lastPts, GstFlowReturn ret, gint64 start)
+{
+	guint64 blocked = (guint64)(g_get_monotonic_time() - start) * GST_USECOND;
+	g_mutex_lock(&stats->lock);
+	stats->bytes += bytes;
+	if (GST_CLOCK_TIME_IS_VALID(lastPts))
 	{
-		GstPad* srcpad = NULL;
-		gboolean discontinuity = FALSE;
+		stats->lastPts = lastPts;
+	}
+	stats->blockedTime += blocked;
+	g_mutex_unlock(&stats->lock);
+	switch (ret)
+	{
+		case GST_FLOW_OK:
+			break;
+		case GST_FLOW_NOT_LINKED:
+			g_atomic_int_inc(&stats->flowNotLinked);
+			break;
+		case GST_FLOW_FLUSHING:
+			g_atomic_int_inc(&stats->flowFlushing);
+			break;
+		case GST_FLOW_EOS:
+			g_atomic_int_inc(&stats->flowEos);
+			break;
+		case GST_FLOW_NOT_NEGOTIATED:
+			g_atomic_int_inc(&stats->flowNotNegotiated);
+			break;
+		default:
+			g_atomic_int_inc(&stats->flowError);
+			break;
+	}
+}
 
-#ifdef AAMP_DISCARD_AUDIO_TRACK
-		if (mediaType == eMEDIATYPE_AUDIO)
-		{
-			GST_WARNING_OBJECT(aamp, "Discard audio track- not sending data\n");
-			return;
-		}
+/**
+ * @brief gst_pad_push() with the push statistics of the pad
+ */
+static GstFlowReturn gst_aamp_pad_push(media_stream *stream, GstBuffer *buffer)
+{
+	guint64 bytes = 0;
+	GstClockTime lastPts = GST_CLOCK_TIME_NONE;
+	gst_aamp_stats_count_buffer(&stream->stats, buffer, &bytes, &lastPts);
+	gint64 start = g_get_monotonic_time();
+	GstFlowReturn ret = gst_pad_push(stream->srcpad, buffer);
+	gst_aamp_stats_count_flow(&stream->stats, bytes, lastPts, ret, start);
+	return ret;
+}
+
+#ifdef USE_GST1
+static GstFlowReturn gst_aamp_pad_push_list(media_stream *stream, GstBufferList *bufferList)
+{
+	guint64 bytes = 0;
+	GstClockTime lastPts = GST_CLOCK_TIME_NONE;
+	guint length = gst_buffer_list_length(bufferList);
+	for (guint i = 0; i < length; i++)
+	{
+		gst_aamp_stats_count_buffer(&stream->stats, gst_buffer_list_get(bufferList, i), &bytes, &lastPts);
+	}
+	gint64 start = g_get_monotonic_time();
+	GstFlowReturn ret = gst_pad_push_list(stream->srcpad, bufferList);
+	gst_aamp_stats_count_flow(&stream->stats, bytes, lastPts, ret, start);
+	return ret;
+}
 #endif
 
-		const char* mediaTypeStr = (mediaType==eMEDIATYPE_AUDIO)?"eMEDIATYPE_AUDIO":"eMEDIATYPE_VIDEO";
-		GST_INFO_OBJECT(aamp, "Enter len = %d fpts %f mediaType %s", (int)len0, fpts, mediaTypeStr);
-		if (!readyToSend)
-		{
-			if (!gst_aamp_ready(aamp))
-			{
-				GST_WARNING_OBJECT(aamp, "Not ready to consume data type %s\n", mediaTypeStr);
-				return;
-			}
-			readyToSend = true;
-		}
-		media_stream* stream = &aamp->stream[mediaType];
-		srcpad = stream->srcpad;
-		if (!srcpad)
+/**
+ * @brief Src pad task, pushes what the Send() path queued on the ring
+ */
+static void gst_aamp_push_loop(gpointer user_data)
+{
+	media_stream *stream = (media_stream *) user_data;
+	GstMiniObject *item = gst_aamp_ring_pop(stream->ring);
+
+	if (!item)
+	{
+		GST_DEBUG_OBJECT(stream->srcpad, "ring flushing, pausing task");
+		gst_pad_pause_task(stream->srcpad);
+		return;
+	}
+	if (GST_IS_EVENT(item))
+	{
+		GstEvent *event = GST_EVENT_CAST(item);
+		GstEventType type = GST_EVENT_TYPE(event);
+		if (!gst_pad_push_event(stream->srcpad, event))
 		{
-			GST_WARNING_OBJECT(aamp, "Pad NULL mediaType: %s (%d)  len = %d fpts %f\n", mediaTypeStr, mediaType, (int)len0, fpts);
-			return;
+			GST_WARNING_OBJECT(stream->srcpad, "push %s event failed", gst_event_type_get_name(type));
 		}
-
-		GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
-		GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
-//#define TRACE_PTS_TRACK 0xff
-#ifdef TRACE_PTS_TRACK
-		if (( mediaType == TRACE_PTS_TRACK ) || (0xFF == TRACE_PTS_TRACK))
+#ifdef USE_GST1
+		else if (type == GST_EVENT_CAPS)
 		{
-			printf("%s : fpts %f pts %llu", (mediaType == eMEDIATYPE_VIDEO)?"vid":"aud", fpts, (unsigned long long)pts);
-			GstClock *clock = GST_ELEMENT_CLOCK(aamp);
-			if (clock)
+			/* The peer has the caps now and can answer for them */
+			GstElement *parent = gst_pad_get_parent_element(stream->srcpad);
+			if (parent)
 			{
-				GstClockTime curr = gst_clock_get_time(clock);
-				printf(" provided clock time %lu diff (pts - curr) %lu (%lu ms)", (unsigned long)curr, (unsigned long)(pts-curr), (unsigned long)(pts-curr)/GST_MSECOND);
+				gst_aamp_decide_allocation(GST_AAMP(parent), stream);
+				gst_object_unref(parent);
 			}
-			logprintf("\n");
 		}
 #endif
-
-		if(stream->eventsPending)
+	}
+	else
+	{
+		GstFlowReturn ret;
+		if (GST_IS_BUFFER_LIST(item))
 		{
-			SendPendingEvents(stream , pts);
-			discontinuity = TRUE;
-
+			ret = gst_aamp_pad_push_list(stream, GST_BUFFER_LIST_CAST(item));
 		}
-#ifdef GSTAAMP_DUMP_STREAM
-		static FILE* fp[2] = {NULL,NULL};
-		static char filename[128];
-		if (!fp[mediaType])
+		else
+		{
+			ret = gst_aamp_pad_push(stream, GST_BUFFER_CAST(item));
+		}
+		if (ret != GST_FLOW_OK)
+		{
+			GST_WARNING_OBJECT(stream->srcpad, "push error: %s", gst_flow_get_name(ret));
+		}
+	}
+}
+
+/**
+ * @brief Start flushing a src pad from outside its pad task
+ *
+ * Flush start goes out of band, ahead of what is queued on the ring, and the ring stops
+ * taking data until gst_aamp_src_flush_stop().
+ */
+static void gst_aamp_src_flush_start(media_stream *stream)
+{
+	g_atomic_int_inc(&stream->stats.flushes);
+	if (!gst_pad_push_event(stream->srcpad, gst_event_new_flush_start()))
+	{
+		GST_WARNING_OBJECT(stream->srcpad, "flush start failed");
+	}
+	if (stream->ring)
+	{
+		gst_aamp_ring_set_flushing(stream->ring, TRUE);
+	}
+}
+
+/**
+ * @brief End a flush begun with gst_aamp_src_flush_start()
+ *
+ * The stream lock is only free once the pad task paused on the flushing ring, the data
+ * queued before the flush is then dropped instead of following flush stop downstream.
+ */
+static void gst_aamp_src_flush_stop(media_stream *stream, gboolean resetTime)
+{
+	GST_PAD_STREAM_LOCK(stream->srcpad);
+#ifdef USE_GST1
+	GstEvent *event = gst_event_new_flush_stop(resetTime);
+#else
+	GstEvent *event = gst_event_new_flush_stop();
+#endif
+	if (!gst_pad_push_event(stream->srcpad, event))
+	{
+		GST_WARNING_OBJECT(stream->srcpad, "flush stop failed");
+	}
+	if (stream->ring)
+	{
+		gst_aamp_ring_drop(stream->ring, stream->srcpad);
+		gst_aamp_ring_set_flushing(stream->ring, FALSE);
+		/* A task stopped by a pad deactivation meanwhile is gone, or finds its ring stopped */
+		GstTask *task = NULL;
+		GST_OBJECT_LOCK(stream->srcpad);
+		if (GST_PAD_TASK(stream->srcpad))
+		{
+			task = (GstTask *) gst_object_ref(GST_PAD_TASK(stream->srcpad));
+		}
+		GST_OBJECT_UNLOCK(stream->srcpad);
+		if (task)
+		{
+			gst_task_start(task);
+			gst_object_unref(task);
+		}
+	}
+	GST_PAD_STREAM_UNLOCK(stream->srcpad);
+}
+
+/**
+ * @brief Have the worker of a track look for work
+ */
+static void gst_aamp_worker_wake(GstAamp * aamp, media_stream *stream)
+{
+	g_mutex_lock(&aamp->mutex);
+	stream->workPending = TRUE;
+	g_cond_broadcast(&aamp->work_changed);
+	g_mutex_unlock(&aamp->mutex);
+}
+
+/**
+ * @brief Flush a src pad for a seek, with the producer of the track held off until the
+ * flush is over
+ *
+ * With a valid replayPosition the pad is marked to replay the seek cache from there, and
+ * the worker of the track does it right away.
+ */
+static void gst_aamp_src_seek_flush(GstAamp * aamp, media_stream *stream, GstClockTime replayPosition)
+{
+	gst_aamp_src_flush_start(stream);
+	g_mutex_lock(&stream->sendMutex);
+	gst_aamp_src_flush_stop(stream, TRUE);
+	if (GST_CLOCK_TIME_IS_VALID(replayPosition))
+	{
+		stream->replayPosition = replayPosition;
+		g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_REPLAY);
+	}
+	g_mutex_unlock(&stream->sendMutex);
+	if (GST_CLOCK_TIME_IS_VALID(replayPosition))
+	{
+		gst_aamp_worker_wake(aamp, stream);
+	}
+}
+
+/**
+ * @brief A pushed fragment that has not been played out yet
+ */
+struct GstAampInflight
+{
+	GstClockTime end;
+	guint64 bytes;
+};
+
+/**
+ * @brief A chunk of a fragment cut on access unit boundaries
+ */
+struct GstAampChunk
+{
+	gsize len;
+	GstClockTime pts;
+	GstClockTime dts;
+	GstClockTime duration;
+};
+
+/**
+ * @brief Current running time of the pipeline, GST_CLOCK_TIME_NONE unless playing
+ */
+static GstClockTime gst_aamp_get_running_time(GstAamp * aamp)
+{
+	GstClockTime runningTime = GST_CLOCK_TIME_NONE;
+	if (GST_STATE(aamp) == GST_STATE_PLAYING)
+	{
+		GstClock *clock = gst_element_get_clock(GST_ELEMENT(aamp));
+		if (clock)
+		{
+			GstClockTime now = gst_clock_get_time(clock);
+			GstClockTime base = gst_element_get_base_time(GST_ELEMENT(aamp));
+			if (now > base)
+			{
+				runningTime = now - base;
+			}
+			gst_object_unref(clock);
+		}
+	}
+	return runningTime;
+}
+
+/* Callers of the gst_aamp_inflight functions hold aamp->mutex */
+static void gst_aamp_inflight_clear(media_stream * stream)
+{
+	GstAampInflight *fragment;
+	while ((fragment = (GstAampInflight *) g_queue_pop_head(&stream->inflight)) != NULL)
+	{
+		g_slice_free(GstAampInflight, fragment);
+	}
+	stream->inflightBytes = 0;
+	stream->pushedTime = GST_CLOCK_TIME_NONE;
+}
+
+static void gst_aamp_inflight_prune(media_stream * stream, GstClockTime runningTime)
+{
+	GstAampInflight *fragment;
+	while ((fragment = (GstAampInflight *) g_queue_peek_head(&stream->inflight)) != NULL && fragment->end <= runningTime)
+	{
+		g_queue_pop_head(&stream->inflight);
+		stream->inflightBytes -= fragment->bytes;
+		g_slice_free(GstAampInflight, fragment);
+	}
+}
+
+/**
+ * @brief Media time a stream has pushed beyond the current running time
+ */
+static GstClockTime gst_aamp_inflight_time(media_stream * stream, GstClockTime runningTime)
+{
+	GstAampInflight *fragment = (GstAampInflight *) g_queue_peek_tail(&stream->inflight);
+	return (fragment && fragment->end > runningTime) ? (fragment->end - runningTime) : 0;
+}
+
+class GstAampStreamer : public StreamSink, public AAMPEventListener
+{
+public:
+	GstAampStreamer(GstAamp * aamp)
+	{
+		this->aamp = aamp;
+		rate = 1.0;
+		srcPadCapsSent = true;
+		format = FORMAT_INVALID;
+		audioFormat = FORMAT_NONE;
+		readyToSend = false;
+		startupQueued = 0;
+		startupBytes = 0;
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		{
+			g_queue_init(&startupQueue[i]);
+		}
+		g_mutex_init(&elementMutex);
+		gst_segment_init(&segment, GST_FORMAT_TIME);
+	}
+
+	~GstAampStreamer()
+	{
+		FreeStartupQueue();
+		g_mutex_clear(&elementMutex);
+	}
+
+	void Configure(StreamOutputFormat format, StreamOutputFormat audioFormat)
+	{
+		GST_INFO_OBJECT(aamp, "Enter format = %d audioFormat = %d", format, audioFormat);
+		this->format = format;
+		this->audioFormat = audioFormat;
+		gst_aamp_configure(aamp, format, audioFormat);
+	}
+
+	void SendPendingEvents(media_stream* stream, GstClockTime pts)
+	{
+		/* Events signalled from here on are left for the next buffer */
+		guint events = g_atomic_int_and(&stream->pendingEvents, 0);
+		if (events & AAMP_EVENT_FLUSH)
+		{
+			/* Out of band and first, so it drops what is still queued for the pad task and
+			 * nothing sent below */
+			gst_aamp_src_flush_start(stream);
+			gst_aamp_src_flush_stop(stream, FALSE);
+			g_mutex_lock(&aamp->mutex);
+			gst_aamp_inflight_clear(stream);
+			g_mutex_unlock(&aamp->mutex);
+		}
+		if (events & AAMP_EVENT_STREAM_START)
+		{
+			GST_INFO_OBJECT(aamp, "sending new_stream_start\n");
+			gboolean ret = PushEvent(stream, gst_event_new_stream_start(aamp->stream_id));
+			if (!ret)
+			{
+				GST_ERROR_OBJECT(aamp, "%s: stream start error\n", __FUNCTION__);
+
+			}
+			GST_INFO_OBJECT(aamp, "%s: sending caps\n", __FUNCTION__);
+			/* A retune may swap the caps of the track meanwhile */
+			g_mutex_lock(&aamp->mutex);
+			GstCaps *caps = gst_caps_ref(stream->caps);
+			g_mutex_unlock(&aamp->mutex);
+			ret = PushEvent(stream, gst_event_new_caps(caps));
+			gst_caps_unref(caps);
+			if (!ret)
+			{
+				GST_ERROR_OBJECT(aamp, "%s: caps evt error\n", __FUNCTION__);
+			}
+#ifdef USE_GST1
+			else if (!stream->ring)
+			{
+				/* The pad task queries once it pushed the caps */
+				gst_aamp_decide_allocation(aamp, stream);
+			}
+#endif
+		}
+		if (events & (AAMP_EVENT_RESET_POSITION | AAMP_EVENT_REPLAY))
+		{
+			if (events & AAMP_EVENT_REPLAY)
+			{
+				/* A seek served from the cache starts at the seek position */
+				pts = stream->replayPosition;
+			}
+#ifdef USE_GST1
+			GstSegment segment;
+			gst_segment_init(&segment, GST_FORMAT_TIME);
+			segment.start = pts;
+			segment.position = 0;
+			segment.rate = 1.0;
+			segment.applied_rate = rate;
+			GST_INFO_OBJECT(aamp, "Sending segment event. start %" G_GUINT64_FORMAT " stop %" G_GUINT64_FORMAT " rate %f\n", segment.start, segment.stop, segment.rate);
+			GstEvent* event = gst_event_new_segment (&segment);
+#else
+			GstEvent* event = gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, pts, GST_CLOCK_TIME_NONE, 0);
+#endif
+			if (!PushEvent(stream, event))
+			{
+				GST_ERROR_OBJECT(aamp, "%s: gst_pad_push_event segment error\n", __FUNCTION__);
+			}
+			stream->segmentStart = pts;
+			/* The reader of a timeshift file went to the seek position itself */
+			if ((events & AAMP_EVENT_REPLAY) && !stream->timeshift)
+			{
+				ReplayCache(stream);
+			}
+		}
+	}
+
+	void Send(MediaType mediaType, const void *ptr, size_t len0, double fpts, double fdts, double fDuration)
+	{
+		if (!readyToSend && QueueStartupFragment(mediaType, (gpointer) ptr, len0, fpts, fdts, fDuration, true))
+		{
+			/* The queue holds a copy */
+			ReleaseFragmentRef(NewFragmentRef(ptr));
+			return;
+		}
+		media_stream* stream = LockStream(mediaType);
+		if (!stream)
+		{
+			ReleaseFragmentRef(NewFragmentRef(ptr));
+			return;
+		}
+		DrainStartupQueue(mediaType);
+		if (stream->timeshift)
+		{
+			WriteTimeshift(stream, ptr, len0, fpts, fdts, fDuration);
+			ReleaseFragmentRef(NewFragmentRef(ptr));
+		}
+		else
+		{
+			SendFragment(mediaType, ptr, len0, fpts, fdts, fDuration, NewFragmentRef(ptr));
+		}
+		g_mutex_unlock(&stream->sendMutex);
+	}
+
+	void Send(MediaType mediaType, GrowableBuffer* pBuffer, double fpts, double fdts, double fDuration)
+	{
+		if (!readyToSend && QueueStartupFragment(mediaType, pBuffer->ptr, pBuffer->len, fpts, fdts, fDuration, false))
+		{
+			/* The queue took over the buffer */
+			memset(pBuffer, 0x00, sizeof(GrowableBuffer));
+			return;
+		}
+		media_stream* stream = LockStream(mediaType);
+		if (!stream)
+		{
+			return;
+		}
+		DrainStartupQueue(mediaType);
+		if (stream->timeshift)
+		{
+			WriteTimeshift(stream, pBuffer->ptr, pBuffer->len, fpts, fdts, fDuration);
+			/* Owned by the sink like a pushed buffer */
+			g_free(pBuffer->ptr);
+			memset(pBuffer, 0x00, sizeof(GrowableBuffer));
+		}
+		else
+		{
+			SendGrowableBuffer(mediaType, pBuffer, fpts, fdts, fDuration);
+		}
+		g_mutex_unlock(&stream->sendMutex);
+	}
+
+	/**
+	 * @brief Work of a track done off the fetcher thread, run by the worker of its pad
+	 *
+	 * A seek served from the seek cache replays from here rather than on the next fragment,
+	 * which may never come at the end of a VOD or while the fetcher is idle. So are the
+	 * fragments queued before the pads were ready, once they are. A track with a timeshift
+	 * file is pushed from here, one fragment per call. Returns true if there is more to do.
+	 */
+	bool Service(MediaType mediaType)
+	{
+		bool more = false;
+		media_stream* stream = &aamp->stream[mediaType];
+		g_mutex_lock(&stream->sendMutex);
+		DrainStartupQueue(mediaType);
+		if (stream->srcpad && stream->timeshift)
+		{
+			more = ReadTimeshift(stream);
+		}
+		else if (stream->srcpad && (g_atomic_int_get(&stream->pendingEvents) & AAMP_EVENT_REPLAY))
+		{
+			SendPendingEvents(stream, stream->replayPosition);
+		}
+		g_mutex_unlock(&stream->sendMutex);
+		return more;
+	}
+
+	/**
+	 * @brief Push a fragment from memory, copied or wrapped if fragmentRef is set
+	 */
+	void SendFragment(MediaType mediaType, const void *ptr, size_t len0, double fpts, double fdts, double fDuration,
+			GstAampFragmentRef* fragmentRef)
+	{
+		GstPad* srcpad = NULL;
+		gboolean discontinuity = FALSE;
+
+#ifdef AAMP_DISCARD_AUDIO_TRACK
+		if (mediaType == eMEDIATYPE_AUDIO)
+		{
+			GST_WARNING_OBJECT(aamp, "Discard audio track- not sending data\n");
+			ReleaseFragmentRef(fragmentRef);
+			return;
+		}
+#endif
+
+		const char* mediaTypeStr = (mediaType==eMEDIATYPE_AUDIO)?"eMEDIATYPE_AUDIO":"eMEDIATYPE_VIDEO";
+		GST_INFO_OBJECT(aamp, "Enter len = %d fpts %f mediaType %s", (int)len0, fpts, mediaTypeStr);
+		media_stream* stream = &aamp->stream[mediaType];
+		srcpad = stream->srcpad;
+		if (!srcpad)
+		{
+			GST_WARNING_OBJECT(aamp, "Pad NULL mediaType: %s (%d)  len = %d fpts %f\n", mediaTypeStr, mediaType, (int)len0, fpts);
+			ReleaseFragmentRef(fragmentRef);
+			return;
+		}
+		g_atomic_int_inc(&stream->stats.fragments);
+
+		GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
+		GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
+//#define TRACE_PTS_TRACK 0xff
+#ifdef TRACE_PTS_TRACK
+		if (( mediaType == TRACE_PTS_TRACK ) || (0xFF == TRACE_PTS_TRACK))
+		{
+			printf("%s : fpts %f pts %llu", (mediaType == eMEDIATYPE_VIDEO)?"vid":"aud", fpts, (unsigned long long)pts);
+			GstClock *clock = GST_ELEMENT_CLOCK(aamp);
+			if (clock)
+			{
+				GstClockTime curr = gst_clock_get_time(clock);
+				printf(" provided clock time %lu diff (pts - curr) %lu (%lu ms)", (unsigned long)curr, (unsigned long)(pts-curr), (unsigned long)(pts-curr)/GST_MSECOND);
+			}
+			logprintf("\n");
+		}
+#endif
+
+		if (g_atomic_int_get(&stream->pendingEvents))
+		{
+			SendPendingEvents(stream , pts);
+			discontinuity = TRUE;
+
+		}
+#ifdef GSTAAMP_DUMP_STREAM
+		static FILE* fp[2] = {NULL,NULL};
+		static char filename[128];
+		if (!fp[mediaType])
 		{
 			sprintf(filename, "gstaampdump%d.ts",mediaType );
 			fp[mediaType] = fopen(filename, "w");
@@ -213,204 +978,1194 @@ public:
 		fwrite(ptr, 1, len0, fp[mediaType] );
 #endif
 
+		SendAudioGap(mediaType, pts, fDuration);
+		WaitForBudget(mediaType, pts, fDuration);
+		size_t fragmentLen = len0;
+		/* Only access unit chunks are scanned, a chunk cut on size is container bytes that
+		 * DELTA_UNIT says nothing about */
+		GArray *accessUnits = aamp->split_access_units ? FindAccessUnits(mediaType, ptr, len0) : NULL;
+		GArray *chunks = accessUnits ? GetAccessUnitChunks(mediaType, accessUnits, len0, pts, dts, fDuration) : NULL;
+		GstClockTime duration = (fDuration > 0) ? (GstClockTime)(fDuration * GST_SECOND) : GST_CLOCK_TIME_NONE;
+		guint chunkIndex = 0;
+		gboolean failed = FALSE;
+		GPtrArray *cached = IsCacheEnabled(stream) ? g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref) : NULL;
+#ifdef USE_GST1
+		GstBufferList *bufferList = NULL;
+		if (aamp->push_buffer_list && (chunks || (GetChunkSize(mediaType, ptr, len0) < len0)))
+		{
+			bufferList = gst_buffer_list_new();
+		}
+#endif
 		while (aamp->player_aamp->aamp->DownloadsAreEnabled())
 		{
-			size_t len = len0;
-			if (len > MAX_BYTES_TO_SEND)
+			size_t len;
+			GstClockTime chunkPts = pts;
+			GstClockTime chunkDts = dts;
+			GstClockTime chunkDuration = GST_CLOCK_TIME_NONE;
+			if (chunks)
+			{
+				GstAampChunk *chunk = &g_array_index(chunks, GstAampChunk, chunkIndex++);
+				len = chunk->len;
+				chunkPts = chunk->pts;
+				chunkDts = chunk->dts;
+				chunkDuration = chunk->duration;
+			}
+			else
+			{
+				len = GetChunkSize(mediaType, ptr, len0);
+				if (len0 == fragmentLen)
+				{
+					chunkDuration = duration;
+				}
+			}
+#ifdef USE_GST1
+			GstBuffer *buffer;
+			if (fragmentRef)
+			{
+				g_atomic_int_inc(&fragmentRef->refcount);
+				buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, (gpointer) ptr, len, 0, len,
+						fragmentRef, gst_aamp_fragment_ref_release);
+			}
+			else
+			{
+				buffer = AllocateBuffer(stream, len);
+				if (!buffer)
+				{
+					GST_ERROR_OBJECT(aamp, "Allocation of %u bytes failed, dropping the rest of the %s fragment",
+							(guint) len, mediaTypeStr);
+					/* The next fragment starts a new segment downstream resyncs on */
+					g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_RESET_POSITION);
+					failed = TRUE;
+					break;
+				}
+				gst_buffer_fill(buffer, 0, ptr, len);
+			}
+			GST_BUFFER_PTS(buffer) = chunkPts;
+			GST_BUFFER_DTS(buffer) = chunkDts;
+#else
+			GstBuffer *buffer = gst_buffer_new_and_alloc((guint) len);
+			memcpy(GST_BUFFER_DATA(buffer), ptr, len);
+			GST_BUFFER_TIMESTAMP(buffer) = chunkPts;
+#endif
+			GST_BUFFER_DURATION(buffer) = chunkDuration;
+			if (chunks && (mediaType == eMEDIATYPE_VIDEO) && IsDeltaUnit(stream, accessUnits, fragmentLen - len0, len))
 			{
-				len = MAX_BYTES_TO_SEND;
+				GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
 			}
+			if (discontinuity)
+			{
+				GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
+				discontinuity = FALSE;
+			}
+			GstBuffer *cachedBuffer = cached ? gst_buffer_ref(buffer) : NULL;
+			GstFlowReturn ret;
+#ifdef USE_GST1
+			if (bufferList)
+			{
+				gst_buffer_list_add(bufferList, buffer);
+				ret = GST_FLOW_OK;
+			}
+			else
+#endif
+			{
+				ret = PushBuffer(stream, buffer);
+			}
+			if (ret != GST_FLOW_OK)
+			{
+				GST_WARNING_OBJECT(aamp, "gst_pad_push error: %s mediaTypeStr %s\n", gst_flow_get_name(ret), mediaTypeStr);
+				if (cachedBuffer)
+				{
+					gst_buffer_unref(cachedBuffer);
+				}
+				break;
+			}
+			if (cachedBuffer)
+			{
+				g_ptr_array_add(cached, cachedBuffer);
+			}
+			ptr = len + (unsigned char *) ptr;
+			len0 -= len;
+			if (len0 == 0)
+			{
+				break;
+			}
+		}
+#ifdef USE_GST1
+		if (bufferList)
+		{
+			if (gst_buffer_list_length(bufferList) > 0)
+			{
+				GstFlowReturn ret = PushBufferList(stream, bufferList);
+				if (ret != GST_FLOW_OK)
+				{
+					GST_WARNING_OBJECT(aamp, "gst_pad_push_list error: %s mediaTypeStr %s\n", gst_flow_get_name(ret), mediaTypeStr);
+				}
+			}
+			else
+			{
+				gst_buffer_list_unref(bufferList);
+			}
+		}
+#endif
+		if (chunks)
+		{
+			g_array_free(chunks, TRUE);
+		}
+		if (accessUnits)
+		{
+			g_array_free(accessUnits, TRUE);
+		}
+		if (cached && !failed && (len0 > 0))
+		{
+			/* The push was cut short by a flush, keep the whole fragment for a replay */
+#ifdef USE_GST1
+			GstBuffer *rest = gst_buffer_new_allocate(NULL, len0, NULL);
+			if (rest)
+			{
+				gst_buffer_fill(rest, 0, ptr, len0);
+				GST_BUFFER_PTS(rest) = pts;
+				GST_BUFFER_DTS(rest) = dts;
+				g_ptr_array_add(cached, rest);
+			}
+			else
+			{
+				failed = TRUE;
+			}
+#else
+			GstBuffer *rest = gst_buffer_new_and_alloc((guint) len0);
+			memcpy(GST_BUFFER_DATA(rest), ptr, len0);
+			GST_BUFFER_TIMESTAMP(rest) = pts;
+			g_ptr_array_add(cached, rest);
+#endif
+		}
+		if (cached)
+		{
+			if (failed)
+			{
+				/* A partial fragment would replay with a hole */
+				g_ptr_array_free(cached, TRUE);
+			}
+			else
+			{
+				CacheFragment(stream, cached, pts, fDuration, fragmentLen);
+			}
+		}
+		AccountInflight(stream, pts, fDuration, fragmentLen);
+		ReleaseFragmentRef(fragmentRef);
+		GST_TRACE_OBJECT(aamp, "Exit");
+	}
+
+	void SendGrowableBuffer(MediaType mediaType, GrowableBuffer* pBuffer, double fpts, double fdts, double fDuration)
+	{
+		GstPad* srcpad = NULL;
+		gboolean discontinuity = FALSE;
+
+#ifdef AAMP_DISCARD_AUDIO_TRACK
+		if (mediaType == eMEDIATYPE_AUDIO)
+		{
+			GST_WARNING_OBJECT(aamp, "Discard audio track- not sending data\n");
+			return;
+		}
+#endif
+
+		const char* mediaTypeStr = (mediaType == eMEDIATYPE_AUDIO) ? "eMEDIATYPE_AUDIO" : "eMEDIATYPE_VIDEO";
+		GST_INFO_OBJECT(aamp, "Enter len = %d fpts %f mediaType %s", (int) pBuffer->len, fpts, mediaTypeStr);
+		media_stream* stream = &aamp->stream[mediaType];
+		srcpad = stream->srcpad;
+		if (!srcpad)
+		{
+			GST_WARNING_OBJECT(aamp, "Pad NULL mediaType: %s (%d)  len = %d fpts %f\n", mediaTypeStr, mediaType,
+			        (int) pBuffer->len, fpts);
+			return;
+		}
+		g_atomic_int_inc(&stream->stats.fragments);
+
+		GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
+		GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
+//#define TRACE_PTS_TRACK 0xff
+#ifdef TRACE_PTS_TRACK
+		if (( mediaType == TRACE_PTS_TRACK ) || (0xFF == TRACE_PTS_TRACK))
+		{
+			printf("%s : fpts %f pts %llu", (mediaType == eMEDIATYPE_VIDEO)?"vid":"aud", fpts, (unsigned long long)pts);
+			GstClock *clock = GST_ELEMENT_CLOCK(aamp);
+			if (clock)
+			{
+				GstClockTime curr = gst_clock_get_time(clock);
+				printf(" provided clock time %lu diff (pts - curr) %lu (%lu ms)", (unsigned long)curr, (unsigned long)(pts-curr), (unsigned long)(pts-curr)/GST_MSECOND);
+			}
+			printf("\n");
+		}
+#endif
+
+		if (g_atomic_int_get(&stream->pendingEvents))
+		{
+			SendPendingEvents(stream, pts);
+			discontinuity = TRUE;
+		}
+#ifdef GSTAAMP_DUMP_STREAM
+		static FILE* fp[2] =
+		{	NULL,NULL};
+		static char filename[128];
+		if (!fp[mediaType])
+		{
+			sprintf(filename, "gstaampdump%d.ts",mediaType );
+			fp[mediaType] = fopen(filename, "w");
+		}
+		fwrite(buffer->ptr, 1, buffer->len, fp[mediaType] );
+#endif
+
+		SendAudioGap(mediaType, pts, fDuration);
+		WaitForBudget(mediaType, pts, fDuration);
+		if (aamp->player_aamp->aamp->DownloadsAreEnabled())
+		{
+			size_t fragmentLen = pBuffer->len;
+			GstClockTime duration = (fDuration > 0) ? (GstClockTime)(fDuration * GST_SECOND) : GST_CLOCK_TIME_NONE;
 #ifdef USE_GST1
-			GstBuffer *buffer = gst_buffer_new_allocate(NULL, (gsize) len, NULL);
-			GstMapInfo map;
-			gst_buffer_map(buffer, &map, GST_MAP_WRITE);
-			memcpy(map.data, ptr, len);
-			gst_buffer_unmap(buffer, &map);
+			GstBuffer* buffer = gst_buffer_new_wrapped (pBuffer->ptr ,pBuffer->len);
 			GST_BUFFER_PTS(buffer) = pts;
 			GST_BUFFER_DTS(buffer) = dts;
+			GST_BUFFER_DURATION(buffer) = duration;
 #else
-			GstBuffer *buffer = gst_buffer_new_and_alloc((guint) len);
-			memcpy(GST_BUFFER_DATA(buffer), ptr, len);
+			GstBuffer* buffer = gst_buffer_new();
+			GST_BUFFER_SIZE(buffer) = pBuffer->len;
+			GST_BUFFER_MALLOCDATA(buffer) = pBuffer->ptr;
+			GST_BUFFER_DATA (buffer) = GST_BUFFER_MALLOCDATA(buffer)
 			GST_BUFFER_TIMESTAMP(buffer) = pts;
+			GST_BUFFER_DURATION(buffer) = duration;
 #endif
 			if (discontinuity)
 			{
 				GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
 				discontinuity = FALSE;
 			}
+			if (IsCacheEnabled(stream))
+			{
+				GPtrArray *cached = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+				g_ptr_array_add(cached, gst_buffer_ref(buffer));
+				CacheFragment(stream, cached, pts, fDuration, fragmentLen);
+			}
 			GstFlowReturn ret;
-			ret = gst_pad_push(srcpad, buffer);
+			ret = PushBuffer(stream, buffer);
 			if (ret != GST_FLOW_OK)
 			{
-				GST_WARNING_OBJECT(aamp, "gst_pad_push error: %s mediaTypeStr %s\n", gst_flow_get_name(ret), mediaTypeStr);
+				GST_WARNING_OBJECT(aamp, "gst_pad_push error: %s mediaTypeStr %s\n", gst_flow_get_name(ret),
+				        mediaTypeStr);
+			}
+			AccountInflight(stream, pts, fDuration, fragmentLen);
+		}
+		/*Since ownership of buffer is given to gstreamer, reset pBuffer */
+		memset(pBuffer, 0x00, sizeof(GrowableBuffer));
+		GST_TRACE_OBJECT(aamp, "Exit");
+	}
+
+	void UpdateRate(gdouble rate)
+	{
+		if ( rate != this->rate)
+		{
+			this->rate = rate;
+		}
+	}
+	void EndOfStreamReached(MediaType type)
+	{
+		media_stream* stream = LockStream(type);
+		if (!stream)
+		{
+			return;
+		}
+		DrainStartupQueue(type);
+		g_mutex_lock(&aamp->mutex);
+		stream->pushedTime = GST_CLOCK_TIME_NONE;
+		g_cond_broadcast(&aamp->budget_changed);
+		g_mutex_unlock(&aamp->mutex);
+		PushEos(stream);
+		g_mutex_unlock(&stream->sendMutex);
+	}
+	void EOS()
+	{
+		const MediaType types[] = { eMEDIATYPE_AUDIO, eMEDIATYPE_VIDEO };
+		for (size_t i = 0; i < G_N_ELEMENTS(types); i++)
+		{
+			media_stream* stream = LockStream(types[i]);
+			if (stream)
+			{
+				PushEos(stream);
+				g_mutex_unlock(&stream->sendMutex);
+			}
+		}
+	}
+	bool Discontinuity(MediaType mediaType)
+	{
+		g_atomic_int_or(&aamp->stream[mediaType].pendingEvents, AAMP_EVENT_RESET_POSITION);
+		return false;
+	}
+	void Flush(double position, float rate)
+	{
+		ClearStartupQueue();
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		{
+			g_atomic_int_set(&aamp->stream[i].eos, 0);
+			/* A pad the seek already flushed, with nothing pushed since, only needs the new segment */
+			if (g_atomic_int_compare_and_exchange(&aamp->stream[i].seekFlushed, 1, 0))
+			{
+				GST_INFO_OBJECT(aamp, "track %d flushed by the seek", i);
+				g_atomic_int_or(&aamp->stream[i].pendingEvents, AAMP_EVENT_RESET_POSITION);
+			}
+			else
+			{
+				g_atomic_int_or(&aamp->stream[i].pendingEvents, AAMP_EVENT_FLUSH | AAMP_EVENT_RESET_POSITION);
+			}
+		}
+		g_atomic_int_set(&aamp->local_seek, 0);
+		g_mutex_lock(&aamp->mutex);
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		{
+			aamp->stream[i].pushedTime = GST_CLOCK_TIME_NONE;
+			gst_aamp_cache_clear(aamp->stream[i].cache);
+			if (aamp->stream[i].timeshift)
+			{
+				gst_aamp_timeshift_clear(aamp->stream[i].timeshift);
+			}
+		}
+		g_cond_broadcast(&aamp->budget_changed);
+		g_mutex_unlock(&aamp->mutex);
+	}
+	/**
+	 * @brief Report to another element, when a standby instance is handed over
+	 *
+	 * Called with the mutex of the current element held, a thread waiting on it for the
+	 * pads then finds the new element when woken. The old element may be dropped right
+	 * after, threads that wait on it hold their own reference, see RefElement().
+	 */
+	void SetElement(GstAamp * element)
+	{
+		g_mutex_lock(&elementMutex);
+		g_atomic_pointer_set(&aamp, element);
+		g_mutex_unlock(&elementMutex);
+	}
+
+	/**
+	 * @brief Drop the queued startup fragments, after a flush or stop they are out of date
+	 */
+	void ClearStartupQueue()
+	{
+		g_mutex_lock(&aamp->mutex);
+		FreeStartupQueue();
+		g_mutex_unlock(&aamp->mutex);
+	}
+	void Event(const AAMPEvent& event);
+private:
+	/**
+	 * @brief Record a pushed fragment against the in-flight budget and the interleave window
+	 */
+	void AccountInflight(media_stream* stream, GstClockTime pts, double fDuration, size_t len)
+	{
+		g_mutex_lock(&aamp->mutex);
+		if (aamp->max_inflight_bytes || aamp->max_inflight_time)
+		{
+			GstAampInflight *fragment = g_slice_new(GstAampInflight);
+			fragment->end = ((pts > stream->segmentStart) ? (pts - stream->segmentStart) : 0) + (GstClockTime)(fDuration * GST_SECOND);
+			fragment->bytes = len;
+			g_queue_push_tail(&stream->inflight, fragment);
+			stream->inflightBytes += len;
+		}
+		stream->pushedTime = pts + (GstClockTime)(fDuration * GST_SECOND);
+		if (aamp->interleave_window)
+		{
+			g_cond_broadcast(&aamp->budget_changed);
+		}
+		g_mutex_unlock(&aamp->mutex);
+	}
+
+	/**
+	 * @brief Check if pushed fragments of a track go to the seek cache, a track with a
+	 * timeshift file replays from the file instead
+	 */
+	bool IsCacheEnabled(media_stream* stream)
+	{
+		return (aamp->seek_cache_time || aamp->seek_cache_bytes) && !stream->timeshift;
+	}
+
+	/**
+	 * @brief Keep the buffers of a pushed fragment in the seek cache of its track
+	 */
+	void CacheFragment(media_stream* stream, GPtrArray *buffers, GstClockTime pts, double fDuration, size_t len)
+	{
+		gst_aamp_cache_add(stream->cache, buffers, pts, pts + (GstClockTime)(fDuration * GST_SECOND), len,
+				aamp->seek_cache_time, aamp->seek_cache_bytes);
+	}
+
+	/**
+	 * @brief Push the cached fragments from the seek position on, after the segment
+	 */
+	void ReplayCache(media_stream* stream)
+	{
+		GstClockTime start = 0;
+		GstClockTime end = 0;
+		gsize bytes = 0;
+		GPtrArray *buffers = gst_aamp_cache_lookup(stream->cache, stream->replayPosition, &start, &end, &bytes);
+		if (!buffers)
+		{
+			GST_WARNING_OBJECT(aamp, "Seek position %" GST_TIME_FORMAT " no longer cached", GST_TIME_ARGS(stream->replayPosition));
+			ReplayEos(stream);
+			return;
+		}
+		GST_INFO_OBJECT(aamp, "Replaying %u cached buffers from %" GST_TIME_FORMAT, buffers->len, GST_TIME_ARGS(start));
+		for (guint i = 0; i < buffers->len; i++)
+		{
+			GstBuffer *buffer = gst_buffer_ref((GstBuffer *) g_ptr_array_index(buffers, i));
+			if (i == 0)
+			{
+				buffer = gst_buffer_make_writable(buffer);
+				GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
+			}
+			GstFlowReturn ret = PushBuffer(stream, buffer);
+			if (ret != GST_FLOW_OK)
+			{
+				GST_WARNING_OBJECT(aamp, "Replay push error: %s", gst_flow_get_name(ret));
 				break;
 			}
-			ptr = len + (unsigned char *) ptr;
-			len0 -= len;
-			if (len0 == 0)
+		}
+		g_ptr_array_unref(buffers);
+		AccountInflight(stream, start, (double)(end - start) / GST_SECOND, bytes);
+		ReplayEos(stream);
+	}
+
+	/**
+	 * @brief End the stream again after a replay if the fetcher had already reached the end,
+	 * it sends nothing more at the end of a VOD
+	 */
+	void ReplayEos(media_stream* stream)
+	{
+		if (g_atomic_int_get(&stream->eos) && !PushEvent(stream, gst_event_new_eos()))
+		{
+			GST_ERROR_OBJECT(aamp, "Replay EOS failed");
+		}
+	}
+
+	/**
+	 * @brief Cover the time of a trick play video fragment on the kept audio pad
+	 *
+	 * No audio is delivered during trick play, the GAP lets the audio sink preroll and
+	 * follow the video instead of stalling the pipeline.
+	 */
+	void SendAudioGap(MediaType mediaType, GstClockTime pts, double fDuration)
+	{
+#ifdef USE_GST1
+		media_stream* stream = &aamp->stream[eMEDIATYPE_AUDIO];
+		if ((mediaType != eMEDIATYPE_VIDEO) || !g_atomic_int_get(&aamp->audio_gap))
+		{
+			return;
+		}
+		/* Taken with the video one held, never the other way round */
+		g_mutex_lock(&stream->sendMutex);
+		if (stream->srcpad)
+		{
+			if (g_atomic_int_get(&stream->pendingEvents))
+			{
+				SendPendingEvents(stream, pts);
+			}
+			GstClockTime duration = (fDuration > 0) ? (GstClockTime)(fDuration * GST_SECOND) : GST_CLOCK_TIME_NONE;
+			if (!PushEvent(stream, gst_event_new_gap(pts, duration)))
+			{
+				GST_WARNING_OBJECT(aamp, "Audio gap event at %" GST_TIME_FORMAT " not handled", GST_TIME_ARGS(pts));
+			}
+		}
+		g_mutex_unlock(&stream->sendMutex);
+#endif
+	}
+
+	/**
+	 * @brief Store a fragment in the timeshift file of its track and wake the worker
+	 *
+	 * The fetcher never waits for downstream, the worker reads the file at the pace of
+	 * playback. While paused the fetcher keeps up with the live edge and playback resumes
+	 * from the file, without reloading from the origin.
+	 */
+	void WriteTimeshift(media_stream* stream, const void *ptr, size_t len, double fpts, double fdts, double fDuration)
+	{
+		GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
+		if (!gst_aamp_timeshift_write(stream->timeshift, ptr, len, pts, (GstClockTime)(fdts * GST_SECOND),
+				pts + (GstClockTime)(fDuration * GST_SECOND)))
+		{
+			GST_WARNING_OBJECT(aamp, "Fragment of %u bytes at %" GST_TIME_FORMAT " does not fit the timeshift file",
+					(guint) len, GST_TIME_ARGS(pts));
+		}
+		gst_aamp_worker_wake(aamp, stream);
+	}
+
+	/**
+	 * @brief Push the next fragment of the timeshift file of a track, caller holds its send mutex
+	 *
+	 * A seek moves the reader to the seek position. Fragments overwritten before they were
+	 * read are skipped and the next one starts a new segment. Returns false once the reader
+	 * caught up with the fetcher, after pushing EOS if the fetcher reached the end.
+	 */
+	bool ReadTimeshift(media_stream* stream)
+	{
+		MediaType mediaType = (MediaType)(stream - aamp->stream);
+		if (g_atomic_int_get(&stream->pendingEvents) & AAMP_EVENT_REPLAY)
+		{
+			if (gst_aamp_timeshift_seek(stream->timeshift, stream->replayPosition, &stream->timeshiftSeq))
+			{
+				GST_INFO_OBJECT(aamp, "Replaying track %d from the timeshift file at %" GST_TIME_FORMAT, mediaType,
+						GST_TIME_ARGS(stream->replayPosition));
+			}
+			else
+			{
+				GST_WARNING_OBJECT(aamp, "Seek position %" GST_TIME_FORMAT " no longer in the timeshift file",
+						GST_TIME_ARGS(stream->replayPosition));
+			}
+			stream->timeshiftEos = FALSE;
+		}
+		guint64 seq = stream->timeshiftSeq;
+		gsize len = 0;
+		GstClockTime pts = 0;
+		GstClockTime dts = 0;
+		GstClockTime end = 0;
+		gpointer data = gst_aamp_timeshift_read(stream->timeshift, &seq, &len, &pts, &dts, &end);
+		if (!data)
+		{
+			if (g_atomic_int_get(&stream->eos) && !stream->timeshiftEos)
+			{
+				stream->timeshiftEos = TRUE;
+				if (!PushEvent(stream, gst_event_new_eos()))
+				{
+					GST_ERROR_OBJECT(aamp, "Send EOS failed for type:%d", mediaType);
+				}
+			}
+			return false;
+		}
+		if (seq != stream->timeshiftSeq)
+		{
+			GST_WARNING_OBJECT(aamp, "Track %d skipped %" G_GUINT64_FORMAT " timeshift fragments overwritten before they were read",
+					mediaType, seq - stream->timeshiftSeq);
+			g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_RESET_POSITION);
+		}
+		stream->timeshiftSeq = seq + 1;
+		stream->timeshiftEos = FALSE;
+		SendFragment(mediaType, data, len, (double) pts / GST_SECOND, (double) dts / GST_SECOND,
+				(double)(end - pts) / GST_SECOND, NewOwnedFragmentRef(data));
+		return true;
+	}
+
+	/**
+	 * @brief Check if a fragment at pts is beyond the interleave window, caller holds aamp->mutex
+	 *
+	 * The other track only sets the limit once it has pushed data and while it has not
+	 * reached the end of stream or been flushed.
+	 */
+	bool IsAheadOfOtherTrack(MediaType mediaType, GstClockTime pts)
+	{
+		/* Before PLAYING the sinks preroll on both tracks, holding one back only delays that */
+		if (!aamp->interleave_window || (aamp->rate != 1.0F) || !GST_CLOCK_TIME_IS_VALID(pts)
+				|| (GST_STATE(aamp) != GST_STATE_PLAYING))
+		{
+			return false;
+		}
+		MediaType other = (mediaType == eMEDIATYPE_AUDIO) ? eMEDIATYPE_VIDEO : eMEDIATYPE_AUDIO;
+		if (!aamp->stream[other].srcpad || ((other == eMEDIATYPE_AUDIO) && !aamp->audio_enabled))
+		{
+			return false;
+		}
+		GstClockTime otherTime = aamp->stream[other].pushedTime;
+		return GST_CLOCK_TIME_IS_VALID(otherTime) && (pts > otherTime + aamp->interleave_window);
+	}
+
+	/**
+	 * @brief Check the in-flight budget for a track, caller holds aamp->mutex
+	 *
+	 * The budget only applies at normal rate once the pipeline clock runs. A track that
+	 * is behind the other one is never held back, the sinks need it to make progress.
+	 */
+	bool IsOverBudget(MediaType mediaType)
+	{
+		GstClockTime runningTime = gst_aamp_get_running_time(aamp);
+		if (!GST_CLOCK_TIME_IS_VALID(runningTime) || (aamp->rate != 1.0F))
+		{
+			return false;
+		}
+		guint64 bytes = 0;
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		{
+			gst_aamp_inflight_prune(&aamp->stream[i], runningTime);
+			bytes += aamp->stream[i].inflightBytes;
+		}
+		GstClockTime ahead = gst_aamp_inflight_time(&aamp->stream[mediaType], runningTime);
+		MediaType other = (mediaType == eMEDIATYPE_AUDIO) ? eMEDIATYPE_VIDEO : eMEDIATYPE_AUDIO;
+		if (aamp->stream[other].srcpad && ((other != eMEDIATYPE_AUDIO) || aamp->audio_enabled)
+				&& (ahead < gst_aamp_inflight_time(&aamp->stream[other], runningTime)))
+		{
+			return false;
+		}
+		if (aamp->max_inflight_bytes && (bytes > aamp->max_inflight_bytes))
+		{
+			return true;
+		}
+		return (aamp->max_inflight_time && (ahead > aamp->max_inflight_time));
+	}
+
+	/**
+	 * @brief Hold Send() back while the data in flight downstream exceeds the budget, or
+	 * while the fragment at pts is too far ahead of the other track
+	 *
+	 * The end of the fragment counts as pushed from then on, the other track is not held
+	 * back while this one blocks in the push.
+	 */
+	void WaitForBudget(MediaType mediaType, GstClockTime pts, double fDuration)
+	{
+		gint64 interleaveDeadline = g_get_monotonic_time() + AAMP_INTERLEAVE_MAX_WAIT_US;
+		while (aamp->player_aamp->aamp->DownloadsAreEnabled())
+		{
+			g_mutex_lock(&aamp->mutex);
+			bool wait = (aamp->state == GST_AAMP_READY)
+					&& (((aamp->max_inflight_bytes || aamp->max_inflight_time) && IsOverBudget(mediaType))
+					|| ((g_get_monotonic_time() < interleaveDeadline) && IsAheadOfOtherTrack(mediaType, pts)));
+			if (wait)
+			{
+				GST_LOG_OBJECT(aamp, "track %d over in-flight budget or interleave window, waiting", mediaType);
+				g_cond_wait_until(&aamp->budget_changed, &aamp->mutex, g_get_monotonic_time() + AAMP_BUDGET_POLL_INTERVAL_US);
+			}
+			else if (GST_CLOCK_TIME_IS_VALID(pts))
+			{
+				aamp->stream[mediaType].pushedTime = pts + (GstClockTime)(fDuration * GST_SECOND);
+				if (aamp->interleave_window)
+				{
+					g_cond_broadcast(&aamp->budget_changed);
+				}
+			}
+			g_mutex_unlock(&aamp->mutex);
+			if (!wait)
+			{
+				break;
+			}
+		}
+	}
+
+	/**
+	 * @brief Push an event, through the pad task in async-push mode to keep it in order with data
+	 */
+	gboolean PushEvent(media_stream* stream, GstEvent* event)
+	{
+		if (stream->ring)
+		{
+			return gst_aamp_ring_push(stream->ring, GST_MINI_OBJECT_CAST(event));
+		}
+		return gst_pad_push_event(stream->srcpad, event);
+	}
+
+	GstFlowReturn PushBuffer(media_stream* stream, GstBuffer* buffer)
+	{
+		GstFlowReturn ret;
+		MarkFirstBuffer(stream, buffer);
+		if (stream->ring)
+		{
+			ret = gst_aamp_ring_push(stream->ring, GST_MINI_OBJECT_CAST(buffer)) ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+		}
+		else
+		{
+			ret = gst_aamp_pad_push(stream, buffer);
+		}
+		EndSeekFlush(stream);
+		return ret;
+	}
+
+#ifdef USE_GST1
+	GstFlowReturn PushBufferList(media_stream* stream, GstBufferList* bufferList)
+	{
+		GstFlowReturn ret;
+		if (gst_buffer_list_length(bufferList) > 0)
+		{
+			MarkFirstBuffer(stream, gst_buffer_list_get(bufferList, 0));
+		}
+		if (stream->ring)
+		{
+			ret = gst_aamp_ring_push(stream->ring, GST_MINI_OBJECT_CAST(bufferList)) ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+		}
+		else
+		{
+			ret = gst_aamp_pad_push_list(stream, bufferList);
+		}
+		EndSeekFlush(stream);
+		return ret;
+	}
+#endif
+
+	/**
+	 * @brief Tune milestones of the first buffer of a pad and the first one after the tune
+	 * discontinuity
+	 *
+	 * A retune while playing is complete with its first video buffer, the pipeline stays in
+	 * PLAYING and posts no state change for it.
+	 */
+	void MarkFirstBuffer(media_stream* stream, GstBuffer* buffer)
+	{
+		gboolean video = (stream == &aamp->stream[eMEDIATYPE_VIDEO]);
+		if (gst_aamp_tune_mark(aamp, video ? GST_AAMP_TUNE_FIRST_VIDEO_BUFFER : GST_AAMP_TUNE_FIRST_AUDIO_BUFFER)
+				&& video && g_atomic_int_compare_and_exchange(&aamp->retune_pending, 1, 0))
+		{
+			gst_aamp_tune_done(aamp);
+		}
+		if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT))
+		{
+			gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_DISCONT_CLEARED);
+		}
+	}
+
+	/**
+	 * @brief Data pushed after a seek flushed the pad needs the flush of the player again
+	 *
+	 * Checked after the push, a buffer that overtook the seek flush either went before it
+	 * or is caught here.
+	 */
+	void EndSeekFlush(media_stream* stream)
+	{
+		if (g_atomic_int_get(&stream->seekFlushed))
+		{
+			g_atomic_int_set(&stream->seekFlushed, 0);
+		}
+	}
+
+	/**
+	 * @brief Length of the next chunk to push from a fragment of len bytes at ptr
+	 */
+	size_t GetChunkSize(MediaType mediaType, const void *ptr, size_t len)
+	{
+		StreamOutputFormat streamFormat = (mediaType == eMEDIATYPE_AUDIO) ? audioFormat : format;
+		size_t chunkSize = gst_aamp_get_max_chunk_size(aamp, streamFormat);
+		if (FORMAT_ISO_BMFF == streamFormat)
+		{
+			return gst_aamp_isobmff_chunk_size((const guint8 *) ptr, len, chunkSize);
+		}
+		if ((0 == chunkSize) || (chunkSize > len))
+		{
+			return len;
+		}
+		return chunkSize;
+	}
+
+	/**
+	 * @brief Access units of an MPEG-TS or ISO BMFF fragment, NULL if it cannot be parsed
+	 */
+	GArray* FindAccessUnits(MediaType mediaType, const void *ptr, size_t len)
+	{
+		StreamOutputFormat streamFormat = (mediaType == eMEDIATYPE_AUDIO) ? audioFormat : format;
+		media_stream* stream = &aamp->stream[mediaType];
+		const guint8 *data = (const guint8 *) ptr;
+		GArray *aus = g_array_new(FALSE, FALSE, sizeof(GstAampAccessUnit));
+		gboolean found = FALSE;
+
+		if (FORMAT_MPEGTS == streamFormat)
+		{
+			found = gst_aamp_ts_find_access_units(data, len, aus);
+		}
+		else if (FORMAT_ISO_BMFF == streamFormat)
+		{
+			guint32 timescale = gst_aamp_isobmff_find_timescale(data, len);
+			if (timescale)
+			{
+				stream->timescale = timescale;
+			}
+			found = gst_aamp_isobmff_find_access_units(data, len, stream->timescale, aus);
+		}
+		if (!found)
+		{
+			g_array_free(aus, TRUE);
+			return NULL;
+		}
+		for (guint i = 0; i < aus->len && !stream->randomAccessSeen; i++)
+		{
+			stream->randomAccessSeen = g_array_index(aus, GstAampAccessUnit, i).sync;
+		}
+		return aus;
+	}
+
+	/**
+	 * @brief TRUE if the bytes [offset, offset + len) of a fragment start no random access point
+	 *
+	 * Nothing is a delta unit until the stream has shown a random access point, TS muxers
+	 * that never set random_access_indicator would otherwise get every buffer flagged.
+	 */
+	bool IsDeltaUnit(media_stream* stream, GArray *aus, size_t offset, size_t len)
+	{
+		if (!aus || !stream->randomAccessSeen)
+		{
+			return false;
+		}
+		for (guint i = 0; i < aus->len; i++)
+		{
+			GstAampAccessUnit *au = &g_array_index(aus, GstAampAccessUnit, i);
+			/* The first chunk carries any bytes in front of the first access unit */
+			size_t start = (i == 0) ? 0 : au->offset;
+			if (au->sync && start >= offset && start < offset + len)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Cut a fragment into chunks of whole access units, each with its own timestamps
+	 *
+	 * Chunks hold as many access units as fit in the chunk size, a larger access unit gets
+	 * a chunk of its own. Returns NULL if there are not enough timed access units, so the
+	 * fragment is chunked on size as usual.
+	 */
+	GArray* GetAccessUnitChunks(MediaType mediaType, GArray *aus, size_t len, GstClockTime pts, GstClockTime dts, double fDuration)
+	{
+		StreamOutputFormat streamFormat = (mediaType == eMEDIATYPE_AUDIO) ? audioFormat : format;
+		if (!aus || aus->len < 2 || ((FORMAT_ISO_BMFF == streamFormat) && !aamp->stream[mediaType].timescale))
+		{
+			return NULL;
+		}
+		/* Chunk lengths are offset differences, they must not wrap or come out empty */
+		for (guint i = 0; i < aus->len; i++)
+		{
+			gsize offset = g_array_index(aus, GstAampAccessUnit, i).offset;
+			if ((offset >= len) || ((i > 0) && (offset <= g_array_index(aus, GstAampAccessUnit, i - 1).offset)))
+			{
+				GST_WARNING_OBJECT(aamp, "Access unit %u offset %" G_GSIZE_FORMAT " out of order, pushing by size", i, offset);
+				return NULL;
+			}
+		}
+
+		size_t maxChunkSize = gst_aamp_get_max_chunk_size(aamp, streamFormat);
+		if (0 == maxChunkSize)
+		{
+			maxChunkSize = MAX_BYTES_TO_SEND;
+		}
+		GstClockTimeDiff end = (fDuration > 0) ? (GstClockTimeDiff)(fDuration * GST_SECOND) : -1;
+		GArray *chunks = g_array_sized_new(FALSE, FALSE, sizeof(GstAampChunk), aus->len);
+		guint i = 0;
+		while (i < aus->len)
+		{
+			GstAampAccessUnit *first = &g_array_index(aus, GstAampAccessUnit, i);
+			gsize start = (i == 0) ? 0 : first->offset;
+			guint next = i + 1;
+			while (next < aus->len)
 			{
-				break;
+				gsize auEnd = (next + 1 < aus->len) ? g_array_index(aus, GstAampAccessUnit, next + 1).offset : len;
+				if (auEnd - start > maxChunkSize)
+				{
+					break;
+				}
+				next++;
 			}
+			GstAampChunk chunk;
+			chunk.len = ((next < aus->len) ? g_array_index(aus, GstAampAccessUnit, next).offset : len) - start;
+			chunk.pts = ((first->pts >= 0) || ((GstClockTime) -first->pts <= pts)) ? pts + first->pts : 0;
+			chunk.dts = ((first->dts >= 0) || ((GstClockTime) -first->dts <= dts)) ? dts + first->dts : 0;
+			GstClockTimeDiff nextDts = (next < aus->len) ? g_array_index(aus, GstAampAccessUnit, next).dts : end;
+			chunk.duration = (nextDts > first->dts) ? (GstClockTime)(nextDts - first->dts) : GST_CLOCK_TIME_NONE;
+			g_array_append_val(chunks, chunk);
+			i = next;
 		}
-		GST_TRACE_OBJECT(aamp, "Exit");
+		return chunks;
 	}
 
-	void Send(MediaType mediaType, GrowableBuffer* pBuffer, double fpts, double fdts, double fDuration)
+	/**
+	 * @brief Start tracking a raw fragment if zero-copy is enabled, NULL otherwise
+	 */
+	GstAampFragmentRef* NewFragmentRef(const void *ptr)
 	{
-		GstPad* srcpad = NULL;
-		gboolean discontinuity = FALSE;
+		GstAampFragmentRef *ref = NULL;
+		g_mutex_lock(&aamp->mutex);
+		if (aamp->release_func)
+		{
+			ref = g_slice_new(GstAampFragmentRef);
+			ref->ptr = ptr;
+			ref->refcount = 1;
+			ref->func = aamp->release_func;
+			ref->user_data = aamp->release_data;
+		}
+		g_mutex_unlock(&aamp->mutex);
+		return ref;
+	}
 
-#ifdef AAMP_DISCARD_AUDIO_TRACK
-		if (mediaType == eMEDIATYPE_AUDIO)
+	/**
+	 * @brief Reference on a fragment in memory allocated with g_malloc(), freed once downstream
+	 * is done with it
+	 */
+	GstAampFragmentRef* NewOwnedFragmentRef(gpointer data)
+	{
+		GstAampFragmentRef *ref = g_slice_new(GstAampFragmentRef);
+		ref->ptr = data;
+		ref->refcount = 1;
+		ref->func = gst_aamp_owned_fragment_release;
+		ref->user_data = NULL;
+		return ref;
+	}
+
+	/**
+	 * @brief Drop the reference held by Send(), buffers still downstream keep the fragment alive
+	 */
+	void ReleaseFragmentRef(GstAampFragmentRef *ref)
+	{
+		if (ref)
 		{
-			GST_WARNING_OBJECT(aamp, "Discard audio track- not sending data\n");
-			return;
+			gst_aamp_fragment_ref_release(ref);
 		}
-#endif
+	}
 
-		const char* mediaTypeStr = (mediaType == eMEDIATYPE_AUDIO) ? "eMEDIATYPE_AUDIO" : "eMEDIATYPE_VIDEO";
-		GST_INFO_OBJECT(aamp, "Enter len = %d fpts %f mediaType %s", (int) pBuffer->len, fpts, mediaTypeStr);
+	/**
+	 * @brief Wait for the src pads and take the send mutex of a track, NULL if the element
+	 * shuts down first
+	 *
+	 * The wait comes first, an element that takes over a standby instance meanwhile brings
+	 * its own streams.
+	 */
+	media_stream* LockStream(MediaType mediaType)
+	{
 		if (!readyToSend)
 		{
-			if (!gst_aamp_ready(aamp))
+			if (!WaitUntilReady())
 			{
-				GST_WARNING_OBJECT(aamp, "Not ready to consume data type %s\n", mediaTypeStr);
-				return;
+				GST_WARNING_OBJECT(aamp, "Not ready to consume data type %d", mediaType);
+				return NULL;
 			}
 			readyToSend = true;
 		}
 		media_stream* stream = &aamp->stream[mediaType];
-		srcpad = stream->srcpad;
-		if (!srcpad)
+		g_mutex_lock(&stream->sendMutex);
+		return stream;
+	}
+
+	/**
+	 * @brief Push EOS on a track, caller holds its send mutex
+	 *
+	 * Remembered until the next flush, a replay from the seek cache or the timeshift file
+	 * ends the stream again.
+	 */
+	void PushEos(media_stream* stream)
+	{
+		g_atomic_int_set(&stream->eos, 1);
+		if (stream->timeshift)
 		{
-			GST_WARNING_OBJECT(aamp, "Pad NULL mediaType: %s (%d)  len = %d fpts %f\n", mediaTypeStr, mediaType,
-			        (int) pBuffer->len, fpts);
-			return;
+			/* Pushed by the worker once it read the file to the end */
+			gst_aamp_worker_wake(aamp, stream);
+		}
+		else if (stream->srcpad && !PushEvent(stream, gst_event_new_eos()))
+		{
+			GST_ERROR_OBJECT(aamp, "Send EOS failed for type:%d\n", (int)(stream - aamp->stream));
 		}
+	}
 
-		GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
-		GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
-//#define TRACE_PTS_TRACK 0xff
-#ifdef TRACE_PTS_TRACK
-		if (( mediaType == TRACE_PTS_TRACK ) || (0xFF == TRACE_PTS_TRACK))
+	/**
+	 * @brief Reference the element the streamer reports to, before the pads are ready
+	 *
+	 * A standby instance can be handed over and dropped meanwhile, the reference keeps
+	 * its mutex and conditions alive while the caller uses them.
+	 */
+	GstAamp* RefElement()
+	{
+		g_mutex_lock(&elementMutex);
+		GstAamp *element = GST_AAMP(gst_object_ref(g_atomic_pointer_get(&aamp)));
+		g_mutex_unlock(&elementMutex);
+		return element;
+	}
+
+	/**
+	 * @brief Wait for the src pads, on the element that took over a standby instance
+	 * if that happened meanwhile
+	 */
+	bool WaitUntilReady()
+	{
+		GstAamp *element = RefElement();
+		bool ready = gst_aamp_ready(element);
+		while (!ready)
 		{
-			printf("%s : fpts %f pts %llu", (mediaType == eMEDIATYPE_VIDEO)?"vid":"aud", fpts, (unsigned long long)pts);
-			GstClock *clock = GST_ELEMENT_CLOCK(aamp);
-			if (clock)
+			GstAamp *next = RefElement();
+			bool handedOver = (next != element);
+			gst_object_unref(element);
+			element = next;
+			if (!handedOver)
 			{
-				GstClockTime curr = gst_clock_get_time(clock);
-				printf(" provided clock time %lu diff (pts - curr) %lu (%lu ms)", (unsigned long)curr, (unsigned long)(pts-curr), (unsigned long)(pts-curr)/GST_MSECOND);
+				break;
 			}
-			printf("\n");
+			ready = gst_aamp_ready(element);
 		}
-#endif
+		gst_object_unref(element);
+		return ready;
+	}
 
-		if (stream->eventsPending)
+	/**
+	 * @brief Keep a fragment that came before the src pads are ready, the fetcher then goes on
+	 * downloading while the pipeline is built
+	 *
+	 * Takes over data, allocated with g_malloc(), on success, or copies it when copy is set.
+	 * Returns false once the element is ready or the queue is full, the caller then waits for
+	 * the pads as before. Space is checked first so nothing is copied that is not queued.
+	 *
+	 * A standby instance stops the downloads of a track once its queue is full, they resume
+	 * when the instance is taken over. A live one makes room for the fragment by dropping the
+	 * oldest of the track instead, so what it pushes first stays close to the live point.
+	 */
+	bool QueueStartupFragment(MediaType mediaType, gpointer data, gsize len, double fpts, double fdts, double fDuration, bool copy)
+	{
+		bool queued = false;
+		bool full = false;
+		GstAamp *element = RefElement();
+		g_mutex_lock(&element->mutex);
+		if (element->standby && (element->state < GST_AAMP_READY) && (startupBytes + len > element->startup_queue_bytes))
 		{
-			SendPendingEvents(stream, pts);
-			discontinuity = TRUE;
+			full = true;
+			if (element->player_aamp->aamp->IsLive())
+			{
+				TrimStartupQueue(mediaType, element->startup_queue_bytes - MIN(len, element->startup_queue_bytes));
+			}
 		}
-#ifdef GSTAAMP_DUMP_STREAM
-		static FILE* fp[2] =
-		{	NULL,NULL};
-		static char filename[128];
-		if (!fp[mediaType])
+		if ((element->state < GST_AAMP_READY) && (startupBytes + len <= element->startup_queue_bytes))
 		{
-			sprintf(filename, "gstaampdump%d.ts",mediaType );
-			fp[mediaType] = fopen(filename, "w");
+			GstAampStartupFragment *fragment = g_slice_new(GstAampStartupFragment);
+			fragment->data = data;
+			if (copy)
+			{
+				fragment->data = g_malloc(len);
+				memcpy(fragment->data, data, len);
+			}
+			fragment->len = len;
+			fragment->fpts = fpts;
+			fragment->fdts = fdts;
+			fragment->fDuration = fDuration;
+			g_queue_push_tail(&startupQueue[mediaType], fragment);
+			startupBytes += len;
+			g_atomic_int_inc(&startupQueued);
+			queued = true;
 		}
-		fwrite(buffer->ptr, 1, buffer->len, fp[mediaType] );
-#endif
+		g_mutex_unlock(&element->mutex);
+		if (full)
+		{
+			element->player_aamp->aamp->StopTrackDownloads(mediaType);
+		}
+		gst_object_unref(element);
+		return queued;
+	}
 
-		if (aamp->player_aamp->aamp->DownloadsAreEnabled())
+	/**
+	 * @brief Drop the oldest queued startup fragments of a track until the queue holds at
+	 * most bytes, caller holds the element mutex
+	 *
+	 * The first fragment of an ISO BMFF track carries its init segment and is kept.
+	 */
+	void TrimStartupQueue(MediaType mediaType, gsize bytes)
+	{
+		StreamOutputFormat streamFormat = (mediaType == eMEDIATYPE_AUDIO) ? audioFormat : format;
+		guint keep = (FORMAT_ISO_BMFF == streamFormat) ? 1 : 0;
+		while ((startupBytes > bytes) && (g_queue_get_length(&startupQueue[mediaType]) > keep))
 		{
-#ifdef USE_GST1
-			GstBuffer* buffer = gst_buffer_new_wrapped (pBuffer->ptr ,pBuffer->len);
-			GST_BUFFER_PTS(buffer) = pts;
-			GST_BUFFER_DTS(buffer) = dts;
-#else
-			GstBuffer* buffer = gst_buffer_new();
-			GST_BUFFER_SIZE(buffer) = pBuffer->len;
-			GST_BUFFER_MALLOCDATA(buffer) = pBuffer->ptr;
-			GST_BUFFER_DATA (buffer) = GST_BUFFER_MALLOCDATA(buffer)
-			GST_BUFFER_TIMESTAMP(buffer) = pts;
-			GST_BUFFER_DURATION(buffer) = duration;
-#endif
-			if (discontinuity)
-			{
-				GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
-				discontinuity = FALSE;
-			}
-			GstFlowReturn ret;
-			ret = gst_pad_push(srcpad, buffer);
-			if (ret != GST_FLOW_OK)
-			{
-				GST_WARNING_OBJECT(aamp, "gst_pad_push error: %s mediaTypeStr %s\n", gst_flow_get_name(ret),
-				        mediaTypeStr);
-			}
+			GstAampStartupFragment *fragment = (GstAampStartupFragment *) g_queue_pop_nth(&startupQueue[mediaType], keep);
+			startupBytes -= fragment->len;
+			g_atomic_int_add(&startupQueued, -1);
+			g_free(fragment->data);
+			g_slice_free(GstAampStartupFragment, fragment);
 		}
-		/*Since ownership of buffer is given to gstreamer, reset pBuffer */
-		memset(pBuffer, 0x00, sizeof(GrowableBuffer));
-		GST_TRACE_OBJECT(aamp, "Exit");
 	}
 
-	void UpdateRate(gdouble rate)
+	/**
+	 * @brief Push the queued startup fragments of a track, in order and ahead of newer ones
+	 *
+	 * Runs with the send mutex of the track held, on its worker as soon as the pads are ready
+	 * or on the next Send() if that comes first. The fragments are wrapped, the queue copy is
+	 * freed once downstream is done with it.
+	 */
+	void DrainStartupQueue(MediaType mediaType)
 	{
-		if ( rate != this->rate)
+		while (g_atomic_int_get(&startupQueued))
 		{
-			this->rate = rate;
+			g_mutex_lock(&aamp->mutex);
+			GstAampStartupFragment *fragment = (GstAampStartupFragment *) g_queue_pop_head(&startupQueue[mediaType]);
+			if (fragment)
+			{
+				startupBytes -= fragment->len;
+				g_atomic_int_add(&startupQueued, -1);
+			}
+			g_mutex_unlock(&aamp->mutex);
+			if (!fragment)
+			{
+				break;
+			}
+			media_stream* stream = &aamp->stream[mediaType];
+			if (stream->timeshift)
+			{
+				WriteTimeshift(stream, fragment->data, fragment->len, fragment->fpts, fragment->fdts, fragment->fDuration);
+				g_free(fragment->data);
+			}
+			else
+			{
+				SendFragment(mediaType, fragment->data, fragment->len, fragment->fpts, fragment->fdts, fragment->fDuration,
+						NewOwnedFragmentRef(fragment->data));
+			}
+			g_slice_free(GstAampStartupFragment, fragment);
 		}
 	}
-	void EndOfStreamReached(MediaType type)
+
+	/**
+	 * @brief Free the queued startup fragments, caller holds aamp->mutex unless tearing down
+	 */
+	void FreeStartupQueue()
 	{
-		GstEvent* event = gst_event_new_eos();
-		if (NULL != aamp->stream[type].srcpad)
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
 		{
-			if (!gst_pad_push_event(aamp->stream[type].srcpad, gst_event_ref(event)))
+			GstAampStartupFragment *fragment;
+			while ((fragment = (GstAampStartupFragment *) g_queue_pop_head(&startupQueue[i])) != NULL)
 			{
-				GST_ERROR_OBJECT(aamp, "Send EOS failed for type:%d\n", type);
+				g_free(fragment->data);
+				g_slice_free(GstAampStartupFragment, fragment);
 			}
 		}
+		startupBytes = 0;
+		g_atomic_int_set(&startupQueued, 0);
 	}
-	void EOS()
+
+#ifdef USE_GST1
+	/**
+	 * @brief Get a buffer of len bytes, from the pad pool when one is free, NULL when out of memory
+	 */
+	GstBuffer* AllocateBuffer(media_stream* stream, size_t len)
 	{
-		GstEvent* event = gst_event_new_eos();
-		if (NULL != aamp->stream[eMEDIATYPE_AUDIO].srcpad)
+		GstBuffer *buffer = NULL;
+		/* The pad task may swap the pool and allocator after an allocation query */
+		g_mutex_lock(&aamp->mutex);
+		GstBufferPool *pool = (stream->pool && (len <= stream->poolBufferSize)) ? (GstBufferPool *) gst_object_ref(stream->pool) : NULL;
+		GstAllocator *allocator = stream->allocator ? (GstAllocator *) gst_object_ref(stream->allocator) : NULL;
+		GstAllocationParams params = stream->allocParams;
+		g_mutex_unlock(&aamp->mutex);
+		if (pool)
 		{
-			if (!gst_pad_push_event(aamp->stream[eMEDIATYPE_AUDIO].srcpad, gst_event_ref(event)))
+			GstBufferPoolAcquireParams acquireParams;
+			memset(&acquireParams, 0, sizeof(acquireParams));
+			acquireParams.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+			if (GST_FLOW_OK == gst_buffer_pool_acquire_buffer(pool, &buffer, &acquireParams))
 			{
-				GST_ERROR_OBJECT(aamp, "Send EOS failed\n");
+				gst_buffer_set_size(buffer, (gssize) len);
+				g_atomic_int_inc(&stream->poolHits);
 			}
+			gst_object_unref(pool);
 		}
-		if (!gst_pad_push_event(aamp->stream[eMEDIATYPE_VIDEO].srcpad, event))
+		if (!buffer)
 		{
-			GST_ERROR_OBJECT(aamp, "Send EOS failed\n");
+			g_atomic_int_inc(&stream->poolMisses);
+			buffer = gst_buffer_new_allocate(allocator, (gsize) len, allocator ? &params : NULL);
 		}
-	}
-	bool Discontinuity(MediaType mediaType)
-	{
-		aamp->stream[mediaType].resetPosition = TRUE;
-		aamp->stream[mediaType].eventsPending = TRUE;
-		return false;
-	}
-	void Flush(double position, float rate)
-	{
-		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		if (allocator)
 		{
-			aamp->stream[i].resetPosition = TRUE;
-			aamp->stream[i].flush = TRUE;
-			aamp->stream[i].eventsPending = TRUE;
+			gst_object_unref(allocator);
 		}
+		return buffer;
 	}
-	void Event(const AAMPEvent& event);
-private:
+#endif
+
 	GstAamp * aamp;
+	GMutex elementMutex;
 	GstSegment segment;
 	gdouble rate;
 	bool srcPadCapsSent;
 	StreamOutputFormat format;
 	StreamOutputFormat audioFormat;
 	bool readyToSend;
+	GQueue startupQueue[AAMP_TRACK_COUNT];
+	gsize startupBytes;
+	gint startupQueued;
 };
 
 #define AAMP_TYPE_INIT_CODE { \
@@ -581,47 +2336,251 @@ static void gst_aamp_cc_stop(GstAamp * aamp)
 
 #endif // AAMP_CC_ENABLED
 
+static void gst_aamp_start_push_task(GstAamp * aamp, media_stream * stream)
+{
+	if (stream->ring)
+	{
+		gst_aamp_ring_set_stopped(stream->ring, FALSE);
+		if (!gst_pad_start_task(stream->srcpad, gst_aamp_push_loop, stream, NULL))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_pad_start_task failed");
+		}
+	}
+}
+
+static void gst_aamp_stop_push_task(GstAamp * aamp, media_stream * stream)
+{
+	if (stream->ring)
+	{
+		gst_aamp_ring_set_stopped(stream->ring, TRUE);
+		if (!gst_pad_stop_task(stream->srcpad))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_pad_stop_task failed");
+		}
+	}
+}
+
+/**
+ * @brief A worker thread and the track it serves
+ */
+struct GstAampWorker
+{
+	GstAamp *aamp;
+	MediaType mediaType;
+};
+
+/**
+ * @brief Create the timeshift files of a live tune, on the first worker to run
+ *
+ * Kept off the state change as allocating the files takes a while. Until they are published
+ * the fetcher pushes as usual, from then on it only writes the file of a track and the worker
+ * of the track pushes from it. Either every track gets a file or timeshift is off.
+ */
+static void gst_aamp_create_timeshift(GstAamp * aamp)
+{
+	GstAampTimeshift *timeshift[AAMP_TRACK_COUNT] = { NULL };
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		if (!aamp->stream[i].srcpad || aamp->stream[i].timeshift)
+		{
+			continue;
+		}
+		timeshift[i] = gst_aamp_timeshift_new(aamp->timeshift_location, (gsize) aamp->timeshift_size);
+		if (!timeshift[i])
+		{
+			GST_WARNING_OBJECT(aamp, "Cannot create %" G_GUINT64_FORMAT " bytes timeshift file in %s, timeshift disabled",
+					aamp->timeshift_size, aamp->timeshift_location ? aamp->timeshift_location : g_get_user_cache_dir());
+			for (int j = 0; j < i; j++)
+			{
+				if (timeshift[j])
+				{
+					gst_aamp_timeshift_free(timeshift[j]);
+				}
+			}
+			return;
+		}
+	}
+	g_mutex_lock(&aamp->mutex);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		if (timeshift[i])
+		{
+			aamp->stream[i].timeshiftSeq = 0;
+			aamp->stream[i].timeshiftEos = FALSE;
+			g_atomic_pointer_set(&aamp->stream[i].timeshift, timeshift[i]);
+		}
+	}
+	g_mutex_unlock(&aamp->mutex);
+}
+
+/**
+ * @brief Run the work of a track off the fetcher thread, while the pads are ready
+ */
+static gpointer gst_aamp_worker_func(gpointer data)
+{
+	GstAampWorker *worker = (GstAampWorker *) data;
+	GstAamp *aamp = worker->aamp;
+	media_stream *stream = &aamp->stream[worker->mediaType];
+	g_mutex_lock(&aamp->mutex);
+	while (aamp->state == GST_AAMP_READY)
+	{
+		if (!stream->workPending)
+		{
+			g_cond_wait(&aamp->work_changed, &aamp->mutex);
+			continue;
+		}
+		stream->workPending = FALSE;
+		g_mutex_unlock(&aamp->mutex);
+		if (g_atomic_int_compare_and_exchange(&aamp->timeshift_pending, TRUE, FALSE))
+		{
+			gst_aamp_create_timeshift(aamp);
+		}
+		bool more = aamp->context->Service(worker->mediaType);
+		g_mutex_lock(&aamp->mutex);
+		stream->workPending = stream->workPending || more;
+	}
+	g_mutex_unlock(&aamp->mutex);
+	g_slice_free(GstAampWorker, worker);
+	return NULL;
+}
+
+/**
+ * @brief Start a worker per track, caller holds the mutex and has made the pads ready
+ */
+static void gst_aamp_start_workers(GstAamp * aamp)
+{
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream *stream = &aamp->stream[i];
+		if (stream->worker)
+		{
+			continue;
+		}
+		GstAampWorker *worker = g_slice_new(GstAampWorker);
+		worker->aamp = aamp;
+		worker->mediaType = (MediaType) i;
+		/* Drains the startup queue right away */
+		stream->workPending = TRUE;
+#ifdef USE_GST1
+		stream->worker = g_thread_new("aamp_worker", gst_aamp_worker_func, worker);
+#else
+		stream->worker = g_thread_create(gst_aamp_worker_func, worker, TRUE, NULL);
+#endif
+		if (!stream->worker)
+		{
+			GST_ERROR_OBJECT(aamp, "Failed to start worker of track %d", i);
+			g_slice_free(GstAampWorker, worker);
+		}
+	}
+}
+
+/**
+ * @brief Join the workers, once the element left the ready state and its pads are inactive
+ */
+static void gst_aamp_stop_workers(GstAamp * aamp)
+{
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream *stream = &aamp->stream[i];
+		if (stream->worker)
+		{
+			g_thread_join(stream->worker);
+			stream->worker = NULL;
+		}
+	}
+}
+
+/**
+ * @brief Src pad activation
+ *
+ * The pad task is stopped here, before deactivation takes the stream lock the task holds
+ * while it waits on an empty ring.
+ */
+#ifdef USE_GST1
+static gboolean gst_aamp_src_activate_mode(GstPad * pad, GstObject * parent, GstPadMode mode, gboolean active)
+{
+	GstAamp *aamp = GST_AAMP(parent);
+#else
+static gboolean gst_aamp_src_activate_push(GstPad * pad, gboolean active)
+{
+	GstAamp *aamp = GST_AAMP(GST_PAD_PARENT(pad));
+#endif
+	if (!active)
+	{
+		for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+		{
+			if (aamp->stream[i].srcpad == pad)
+			{
+				gst_aamp_stop_push_task(aamp, &aamp->stream[i]);
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Add or remove the audio pad for the current rate
+ *
+ * Called without the mutex, removing the pad joins its task.
+ */
 static void gst_aamp_update_audio_src_pad(GstAamp * aamp)
 {
 #ifndef AAMP_DISCARD_AUDIO_TRACK
-	if (NULL != aamp->stream[eMEDIATYPE_AUDIO].srcpad)
+	media_stream *stream = &aamp->stream[eMEDIATYPE_AUDIO];
+	gboolean add = FALSE;
+	gboolean remove = FALSE;
+	g_mutex_lock(&aamp->mutex);
+	if (NULL != stream->srcpad)
 	{
 		gboolean enable_audio;
 		if ( aamp->rate != 1.0F)
 		{
+#ifdef USE_GST1
+			/* Keeping the pad saves rebuilding the audio branch when 1x play resumes */
+			enable_audio = aamp->keep_audio_pad;
+#else
 			enable_audio = FALSE;
+#endif
 		}
 		else
 		{
 			enable_audio = TRUE;
 		}
-		if (enable_audio && !aamp->audio_enabled)
+		g_atomic_int_set(&aamp->audio_gap, enable_audio && (aamp->rate != 1.0F));
+		add = enable_audio && !aamp->audio_enabled;
+		remove = !enable_audio && aamp->audio_enabled;
+		aamp->audio_enabled = enable_audio;
+	}
+	g_mutex_unlock(&aamp->mutex);
+
+	if (add)
+	{
+		GST_INFO_OBJECT(aamp, "Enable aud and add pad");
+		if (FALSE == gst_pad_set_active (stream->srcpad, TRUE))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_pad_set_active failed");
+		}
+		if (FALSE == gst_element_add_pad(GST_ELEMENT(aamp), stream->srcpad))
 		{
-			GST_INFO_OBJECT(aamp, "Enable aud and add pad");
-			if (FALSE == gst_pad_set_active (aamp->stream[eMEDIATYPE_AUDIO].srcpad, TRUE))
-			{
-				GST_WARNING_OBJECT(aamp, "gst_pad_set_active failed");
-			}
-			if (FALSE == gst_element_add_pad(GST_ELEMENT(aamp), aamp->stream[eMEDIATYPE_AUDIO].srcpad))
-			{
-				GST_WARNING_OBJECT(aamp, "gst_element_add_pad stream[eMEDIATYPE_AUDIO].srcpad failed");
-			}
-			aamp->stream[eMEDIATYPE_AUDIO].streamStart = TRUE;
-			aamp->stream[eMEDIATYPE_AUDIO].eventsPending = TRUE;
-			aamp->audio_enabled = TRUE;
+			GST_WARNING_OBJECT(aamp, "gst_element_add_pad stream[eMEDIATYPE_AUDIO].srcpad failed");
 		}
-		else if (!enable_audio && aamp->audio_enabled)
+		g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_STREAM_START);
+		gst_aamp_start_push_task(aamp, stream);
+	}
+	else if (remove)
+	{
+		GST_INFO_OBJECT(aamp, "Disable aud and remove pad");
+		/* A push blocked downstream would keep the task from stopping */
+		gst_aamp_src_flush_start(stream);
+		gst_aamp_stop_push_task(aamp, stream);
+		gst_aamp_src_flush_stop(stream, TRUE);
+		if (FALSE == gst_pad_set_active (stream->srcpad, FALSE))
 		{
-			GST_INFO_OBJECT(aamp, "Disable aud and remove pad");
-			if (FALSE == gst_pad_set_active (aamp->stream[eMEDIATYPE_AUDIO].srcpad, FALSE))
-			{
-				GST_WARNING_OBJECT(aamp, "gst_pad_set_active FALSE failed");
-			}
-			if (FALSE == gst_element_remove_pad(GST_ELEMENT(aamp), aamp->stream[eMEDIATYPE_AUDIO].srcpad))
-			{
-				GST_WARNING_OBJECT(aamp, "gst_element_remove_pad stream[eMEDIATYPE_AUDIO].srcpad failed");
-			}
-			aamp->audio_enabled = FALSE;
+			GST_WARNING_OBJECT(aamp, "gst_pad_set_active FALSE failed");
+		}
+		if (FALSE == gst_element_remove_pad(GST_ELEMENT(aamp), stream->srcpad))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_element_remove_pad stream[eMEDIATYPE_AUDIO].srcpad failed");
 		}
 	}
 #endif
@@ -671,64 +2630,374 @@ static GstCaps* GetGstCaps(StreamOutputFormat format)
 	return caps;
 }
 
-static void gst_aamp_configure(GstAamp * aamp, StreamOutputFormat format, StreamOutputFormat audioFormat)
+/**
+ * @brief Fixed chunk size used for a format, 0 if fragments are not split on a size
+ *
+ * MPEG-TS chunks are whole TS packets. ISO BMFF fragments are split on box boundaries
+ * and ES fragments, which hold whole frames, are sent unsplit unless chunk-size is set.
+ */
+static gsize gst_aamp_get_max_chunk_size(GstAamp * aamp, StreamOutputFormat format)
 {
-	GstCaps *caps;
-	gchar * padname = NULL;
+	gsize chunkSize = aamp->chunk_size;
+	if (FORMAT_MPEGTS == format)
+	{
+		if (0 == chunkSize)
+		{
+			chunkSize = MAX_BYTES_TO_SEND;
+		}
+		chunkSize -= chunkSize % AAMP_TS_PACKET_SIZE;
+		if (0 == chunkSize)
+		{
+			chunkSize = AAMP_TS_PACKET_SIZE;
+		}
+	}
+	return chunkSize;
+}
 
-	g_mutex_lock (&aamp->mutex);
-	if ( aamp->state >= GST_AAMP_CONFIGURED )
+#ifdef USE_GST1
+/**
+ * @brief Size of the buffers in the pool of a src pad carrying format
+ */
+static gsize gst_aamp_get_pool_buffer_size(GstAamp * aamp, StreamOutputFormat format)
+{
+	gsize size = gst_aamp_get_max_chunk_size(aamp, format);
+	if (0 == size)
 	{
-		gst_aamp_update_audio_src_pad(aamp);
-		g_mutex_unlock (&aamp->mutex);
-		GST_INFO_OBJECT(aamp, "Already configured");
+		/* No fixed chunk size, access units and boxes up to this size still come from the pool */
+		size = MAX_BYTES_TO_SEND;
+	}
+	return size;
+}
+
+static GstBufferPool* gst_aamp_create_buffer_pool(GstAamp * aamp, GstCaps * caps, guint size)
+{
+	GstBufferPool *pool = gst_buffer_pool_new();
+	GstStructure *config = gst_buffer_pool_get_config(pool);
+	gst_buffer_pool_config_set_params(config, caps, size, AAMP_BUFFER_POOL_MIN_BUFFERS, AAMP_BUFFER_POOL_MAX_BUFFERS);
+	if (!gst_buffer_pool_set_config(pool, config))
+	{
+		GST_WARNING_OBJECT(aamp, "Buffer pool configuration failed");
+		gst_object_unref(pool);
+		pool = NULL;
+	}
+	return pool;
+}
+
+/**
+ * @brief Run an ALLOCATION query on a src pad and take over the allocator of the peer, and
+ * the pool it proposes
+ *
+ * Raw fragments are then copied once, straight into memory the decoder can use. As for
+ * any upstream element, a proposed pool is configured and activated here and owned by the
+ * pad from then on. A pool that is already active belongs to someone else and is passed
+ * over, the pad then fills its own pool from the peer allocator.
+ * Called by the thread that pushed the caps, once the peer has them.
+ */
+static void gst_aamp_decide_allocation(GstAamp * aamp, media_stream * stream)
+{
+	g_mutex_lock(&aamp->mutex);
+	GstCaps *caps = gst_caps_ref(stream->caps);
+	gsize poolBufferSize = stream->poolBufferSize;
+	g_mutex_unlock(&aamp->mutex);
+	GstQuery *query = gst_query_new_allocation(caps, TRUE);
+	GstAllocator *allocator = NULL;
+	GstAllocationParams params;
+	GstBufferPool *pool = NULL;
+	guint size = 0;
+
+	gst_allocation_params_init(&params);
+	if (!gst_pad_peer_query(stream->srcpad, query))
+	{
+		GST_INFO_OBJECT(aamp, "Peer of %s:%s did not answer the allocation query", GST_DEBUG_PAD_NAME(stream->srcpad));
+		gst_query_unref(query);
+		gst_caps_unref(caps);
 		return;
 	}
-	g_mutex_unlock (&aamp->mutex);
+	if (gst_query_get_n_allocation_params(query) > 0)
+	{
+		gst_query_parse_nth_allocation_param(query, 0, &allocator, &params);
+	}
+	if (gst_query_get_n_allocation_pools(query) > 0)
+	{
+		gst_query_parse_nth_allocation_pool(query, 0, &pool, &size, NULL, NULL);
+	}
+	gst_query_unref(query);
+
+	if (pool && gst_buffer_pool_is_active(pool))
+	{
+		GST_INFO_OBJECT(aamp, "Pool proposed on %s:%s is already in use", GST_DEBUG_PAD_NAME(stream->srcpad));
+		gst_object_unref(pool);
+		pool = NULL;
+	}
+	if (pool)
+	{
+		poolBufferSize = MAX(poolBufferSize, size);
+		GstStructure *config = gst_buffer_pool_get_config(pool);
+		gst_buffer_pool_config_set_params(config, caps, poolBufferSize, AAMP_BUFFER_POOL_MIN_BUFFERS,
+				AAMP_BUFFER_POOL_MAX_BUFFERS);
+		if (allocator)
+		{
+			gst_buffer_pool_config_set_allocator(config, allocator, &params);
+		}
+		if (gst_buffer_pool_set_config(pool, config) && gst_buffer_pool_set_active(pool, TRUE))
+		{
+			GST_INFO_OBJECT(aamp, "Using pool proposed on %s:%s, buffer size %" G_GSIZE_FORMAT,
+					GST_DEBUG_PAD_NAME(stream->srcpad), poolBufferSize);
+		}
+		else
+		{
+			GST_INFO_OBJECT(aamp, "Pool proposed on %s:%s rejected the configuration", GST_DEBUG_PAD_NAME(stream->srcpad));
+			gst_object_unref(pool);
+			pool = NULL;
+			poolBufferSize = stream->poolBufferSize;
+		}
+	}
+	if (!pool && allocator)
+	{
+		/* Our own pool, filled from the peer allocator */
+		pool = gst_buffer_pool_new();
+		GstStructure *config = gst_buffer_pool_get_config(pool);
+		gst_buffer_pool_config_set_params(config, caps, poolBufferSize, AAMP_BUFFER_POOL_MIN_BUFFERS,
+				AAMP_BUFFER_POOL_MAX_BUFFERS);
+		gst_buffer_pool_config_set_allocator(config, allocator, &params);
+		if (!gst_buffer_pool_set_config(pool, config) || !gst_buffer_pool_set_active(pool, TRUE))
+		{
+			gst_object_unref(pool);
+			pool = NULL;
+		}
+	}
+	gst_caps_unref(caps);
+
+	g_mutex_lock(&aamp->mutex);
+	GstBufferPool *oldPool = NULL;
+	if (pool)
+	{
+		oldPool = stream->pool;
+		stream->pool = pool;
+		stream->poolBufferSize = poolBufferSize;
+	}
+	GstAllocator *oldAllocator = stream->allocator;
+	stream->allocator = allocator;
+	stream->allocParams = params;
+	g_mutex_unlock(&aamp->mutex);
+
+	if (oldPool)
+	{
+		gst_buffer_pool_set_active(oldPool, FALSE);
+		gst_object_unref(oldPool);
+	}
+	if (oldAllocator)
+	{
+		gst_object_unref(oldAllocator);
+	}
+}
+
+static void gst_aamp_set_buffer_pools_active(GstAamp * aamp, gboolean active)
+{
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream* stream = &aamp->stream[i];
+		if (stream->pool && !gst_buffer_pool_set_active(stream->pool, active))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_buffer_pool_set_active %d failed for track %d", active, i);
+		}
+		if (!active)
+		{
+			GST_INFO_OBJECT(aamp, "track %d pool hits %d misses %d", i, g_atomic_int_get(&stream->poolHits),
+					g_atomic_int_get(&stream->poolMisses));
+		}
+	}
+}
+#endif
+
+/**
+ * @brief Create a src pad for a track, named after the pads the track had before
+ */
+static GstPad* gst_aamp_new_src_pad(GstAamp * aamp, MediaType mediaType)
+{
+	media_stream* stream = &aamp->stream[mediaType];
+	gchar *padname = g_strdup_printf((mediaType == eMEDIATYPE_VIDEO) ? "video_%02x" : "audio_%02x", ++stream->padSerial);
+	GstPad *srcpad = gst_pad_new_from_static_template(
+			(mediaType == eMEDIATYPE_VIDEO) ? &gst_aamp_src_template_video : &gst_aamp_src_template_audio, padname);
+	gst_object_ref(srcpad);
+	gst_pad_use_fixed_caps(srcpad);
+	GST_OBJECT_FLAG_SET(srcpad, GST_PAD_FLAG_NEED_PARENT);
+	gst_pad_set_query_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_query));
+	gst_pad_set_event_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_event));
+#ifdef USE_GST1
+	gst_pad_set_activatemode_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_activate_mode));
+#else
+	gst_pad_set_activatepush_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_activate_push));
+#endif
+	GST_INFO_OBJECT(aamp, "Created pad %s", padname);
+	g_free(padname);
+	return srcpad;
+}
+
+/**
+ * @brief Put srcpad in place of the src pad of a track, or only drop the pad when srcpad
+ * is NULL
+ *
+ * Caps cannot change on a pad linked to the parser and decoder plugged for the old
+ * format. As a demuxer does on a program change, the new pad is exposed first, then the
+ * old one gets EOS and is removed, and decodebin plugs a new chain. The producers of the
+ * track are held off meanwhile.
+ */
+static void gst_aamp_replace_src_pad(GstAamp * aamp, MediaType mediaType, GstPad * srcpad, GstCaps * caps,
+		StreamOutputFormat format, GstBufferPool * pool, gsize poolBufferSize)
+{
+	media_stream* stream = &aamp->stream[mediaType];
+	GstPad *oldPad = stream->srcpad;
+	gboolean exposed = (GST_OBJECT_PARENT(oldPad) == GST_OBJECT_CAST(aamp));
+	if (exposed)
+	{
+		/* Unblocks a producer waiting on downstream before its lock is taken */
+		gst_aamp_src_flush_start(stream);
+	}
+	g_mutex_lock(&stream->sendMutex);
+	if (exposed)
+	{
+		gst_aamp_stop_push_task(aamp, stream);
+		gst_aamp_src_flush_stop(stream, TRUE);
+	}
 
-	caps = GetGstCaps(format);
+	g_mutex_lock(&aamp->mutex);
+	GstCaps *oldCaps = stream->caps;
+	stream->srcpad = srcpad;
+	stream->caps = caps;
+	stream->format = format;
+#ifdef USE_GST1
+	GstBufferPool *oldPool = stream->pool;
+	stream->pool = pool;
+	stream->poolBufferSize = poolBufferSize;
+	if (pool && (aamp->state == GST_AAMP_READY))
+	{
+		gst_buffer_pool_set_active(pool, TRUE);
+	}
+#endif
+	if (!srcpad && (mediaType == eMEDIATYPE_AUDIO))
+	{
+		aamp->audio_enabled = FALSE;
+		g_atomic_int_set(&aamp->audio_gap, 0);
+	}
+	g_mutex_unlock(&aamp->mutex);
 
-	if (caps)
+	if (srcpad)
 	{
-		padname = g_strdup_printf ("video_%02x", 1);
-		GstPad *srcpad = gst_pad_new_from_static_template(&gst_aamp_src_template_video, padname);
-		gst_object_ref(srcpad);
-		gst_pad_use_fixed_caps(srcpad);
-		GST_OBJECT_FLAG_SET(srcpad, GST_PAD_FLAG_NEED_PARENT);
-		gst_pad_set_query_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_query));
-		gst_pad_set_event_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_event));
-		aamp->stream[eMEDIATYPE_VIDEO].caps= caps;
-		aamp->stream[eMEDIATYPE_VIDEO].srcpad = srcpad;
-		if (padname)
+		g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_STREAM_START);
+	}
+	if (srcpad && exposed)
+	{
+		if (FALSE == gst_pad_set_active(srcpad, TRUE))
 		{
-			GST_INFO_OBJECT(aamp, "Created pad %s", padname);
-		    g_free (padname);
+			GST_WARNING_OBJECT(aamp, "gst_pad_set_active failed");
 		}
-		aamp->stream_id = gst_pad_create_stream_id(srcpad, GST_ELEMENT(aamp), NULL);
+		if (FALSE == gst_element_add_pad(GST_ELEMENT(aamp), srcpad))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_element_add_pad %s:%s failed", GST_DEBUG_PAD_NAME(srcpad));
+		}
+		gst_aamp_start_push_task(aamp, stream);
+		gst_element_no_more_pads(GST_ELEMENT(aamp));
 	}
-	else
+	if (exposed)
+	{
+		gst_pad_push_event(oldPad, gst_event_new_eos());
+		if (FALSE == gst_pad_set_active(oldPad, FALSE))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_pad_set_active FALSE failed");
+		}
+		if (FALSE == gst_element_remove_pad(GST_ELEMENT(aamp), oldPad))
+		{
+			GST_WARNING_OBJECT(aamp, "gst_element_remove_pad %s:%s failed", GST_DEBUG_PAD_NAME(oldPad));
+		}
+	}
+	g_mutex_unlock(&stream->sendMutex);
+
+	gst_object_unref(oldPad);
+	gst_caps_unref(oldCaps);
+#ifdef USE_GST1
+	if (oldPool)
+	{
+		gst_buffer_pool_set_active(oldPool, FALSE);
+		gst_object_unref(oldPool);
+	}
+#endif
+}
+
+/**
+ * @brief Set up the src pad of a track for format
+ *
+ * A pad that already carries format is kept with its caps, pool and stream-start, so a
+ * retune to the same codecs leaves the decoders downstream alone. A pad of another format
+ * is replaced, and the pad of a track the new content does not have is removed.
+ */
+static void gst_aamp_configure_track(GstAamp * aamp, MediaType mediaType, StreamOutputFormat format)
+{
+	media_stream* stream = &aamp->stream[mediaType];
+	if (stream->srcpad && (stream->format == format))
+	{
+		GST_INFO_OBJECT(aamp, "Reusing pad %s:%s for format %d", GST_DEBUG_PAD_NAME(stream->srcpad), format);
+		return;
+	}
+
+	GstCaps *caps = GetGstCaps(format);
+	if (!caps)
 	{
-		GST_INFO_OBJECT(aamp, "Unsupported videoFormat %d", format);
+		GST_INFO_OBJECT(aamp, "Unsupported %s format %d", (mediaType == eMEDIATYPE_VIDEO) ? "video" : "audio", format);
+		if (stream->srcpad)
+		{
+			/* Left in place it would hold preroll waiting for data */
+			GST_INFO_OBJECT(aamp, "Removing pad %s:%s", GST_DEBUG_PAD_NAME(stream->srcpad));
+			gst_aamp_replace_src_pad(aamp, mediaType, NULL, NULL, format, NULL, 0);
+		}
+		return;
 	}
+	GstBufferPool *pool = NULL;
+	gsize poolBufferSize = 0;
+#ifdef USE_GST1
+	poolBufferSize = gst_aamp_get_pool_buffer_size(aamp, format);
+	pool = gst_aamp_create_buffer_pool(aamp, caps, poolBufferSize);
+#endif
 
-	caps = GetGstCaps(audioFormat);
-	if (caps)
+	GstPad *srcpad = gst_aamp_new_src_pad(aamp, mediaType);
+	if (stream->srcpad)
+	{
+		GST_INFO_OBJECT(aamp, "Format of %s:%s changed from %d to %d, replacing it with %s:%s",
+				GST_DEBUG_PAD_NAME(stream->srcpad), stream->format, format, GST_DEBUG_PAD_NAME(srcpad));
+		gst_aamp_replace_src_pad(aamp, mediaType, srcpad, caps, format, pool, poolBufferSize);
+		return;
+	}
+	stream->caps = caps;
+	stream->format = format;
+	stream->srcpad = srcpad;
+	stream->poolBufferSize = poolBufferSize;
+	stream->pool = pool;
+	if (mediaType == eMEDIATYPE_VIDEO)
 	{
-		padname = g_strdup_printf ("audio_%02x", 1);
-		GstPad *srcpad = gst_pad_new_from_static_template(&gst_aamp_src_template_audio, padname);
-		gst_object_ref(srcpad);
-		gst_pad_use_fixed_caps(srcpad);
-		GST_OBJECT_FLAG_SET(srcpad, GST_PAD_FLAG_NEED_PARENT);
-		gst_pad_set_query_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_query));
-		gst_pad_set_event_function(srcpad, GST_DEBUG_FUNCPTR(gst_aamp_src_event));
-		aamp->stream[eMEDIATYPE_AUDIO].srcpad = srcpad;
-		aamp->stream[eMEDIATYPE_AUDIO].caps= caps;
+		g_free(aamp->stream_id);
+		aamp->stream_id = gst_pad_create_stream_id(srcpad, GST_ELEMENT(aamp), NULL);
 	}
+}
+
+static void gst_aamp_configure(GstAamp * aamp, StreamOutputFormat format, StreamOutputFormat audioFormat)
+{
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_CONFIGURED);
+	gst_aamp_configure_track(aamp, eMEDIATYPE_VIDEO, format);
+	gst_aamp_configure_track(aamp, eMEDIATYPE_AUDIO, audioFormat);
 
 	g_mutex_lock (&aamp->mutex);
-	aamp->state = GST_AAMP_CONFIGURED;
-	g_cond_signal(&aamp->state_changed);
+	gboolean configured = (aamp->state >= GST_AAMP_CONFIGURED);
+	if (!configured)
+	{
+		aamp->state = GST_AAMP_CONFIGURED;
+		g_cond_signal(&aamp->state_changed);
+	}
 	g_mutex_unlock (&aamp->mutex);
+	if (configured)
+	{
+		gst_aamp_update_audio_src_pad(aamp);
+		GST_INFO_OBJECT(aamp, "Already configured");
+	}
 }
 
 static void gst_aamp_class_init(GstAampClass * klass)
@@ -751,6 +3020,134 @@ static void gst_aamp_class_init(GstAampClass * klass)
 	gst_element_class_set_static_metadata(GST_ELEMENT_CLASS(klass), "Advanced Adaptive Media Player", "Demux",
 			"Advanced Adaptive Media Player", "Comcast");
 
+	gobject_class->set_property = gst_aamp_set_property;
+	gobject_class->get_property = gst_aamp_get_property;
+	g_object_class_install_property(gobject_class, PROP_LOCATION,
+			g_param_spec_string("location", "Location",
+					"URI to play, taken from upstream if not set. Setting it while playing retunes in place", NULL,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_TUNE_TIMES,
+			g_param_spec_boxed("tune-times", "Tune times",
+					"Microseconds from the start of the last tune to each milestone, set once it plays", GST_TYPE_STRUCTURE,
+					(GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_STATS,
+			g_param_spec_boxed("stats", "Statistics",
+					"Push statistics per src pad, buffer pool hits and misses are in pool-stats", GST_TYPE_STRUCTURE,
+					(GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_POOL_STATS,
+			g_param_spec_boxed("pool-stats", "Pool statistics",
+					"Src pad buffer pool hits and misses of the raw send path", GST_TYPE_STRUCTURE,
+					(GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_PUSH_BUFFER_LIST,
+			g_param_spec_boolean("push-buffer-list", "Push buffer list",
+					"Push the chunks of a fragment as one buffer list", FALSE,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_ASYNC_PUSH,
+			g_param_spec_boolean("async-push", "Async push",
+					"Push from a task per src pad so Send() returns once data is queued", FALSE,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_RING_DEPTH,
+			g_param_spec_uint("ring-depth", "Ring depth",
+					"Items queued per src pad in async-push mode", 2, 4096, AAMP_DEFAULT_RING_DEPTH,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_RING_STATS,
+			g_param_spec_boxed("ring-stats", "Ring statistics",
+					"Async-push ring level and time Send() spent blocked on a full ring", GST_TYPE_STRUCTURE,
+					(GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_MAX_INFLIGHT_BYTES,
+			g_param_spec_uint64("max-inflight-bytes", "Max in-flight bytes",
+					"Bytes pushed on all src pads and not yet played out before Send() throttles (0 = unlimited)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_MAX_INFLIGHT_TIME,
+			g_param_spec_uint64("max-inflight-time", "Max in-flight time",
+					"Media time in ns a src pad may be ahead of playback before Send() throttles (0 = unlimited)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_SPLIT_ACCESS_UNITS,
+			g_param_spec_boolean("split-access-units", "Split on access units",
+					"Cut MPEG-TS and ISO BMFF fragments on access unit boundaries and timestamp each chunk", FALSE,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_INTERLEAVE_WINDOW,
+			g_param_spec_uint64("interleave-window", "Interleave window",
+					"Media time in ns a src pad may be pushed ahead of the other one (0 = unlimited)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_SEEK_CACHE_TIME,
+			g_param_spec_uint64("seek-cache-time", "Seek cache time",
+					"Media time in ns of pushed fragments kept per track to serve seeks back locally (0 = unlimited)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_SEEK_CACHE_BYTES,
+			g_param_spec_uint64("seek-cache-bytes", "Seek cache bytes",
+					"Bytes of pushed fragments kept per track to serve seeks back locally (0 = unlimited)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_TIMESHIFT_SIZE,
+			g_param_spec_uint64("timeshift-size", "Timeshift size",
+					"Bytes per track of the memory-mapped file live fragments are kept in for pause and rewind (0 = disabled)",
+					0, G_MAXSIZE, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_TIMESHIFT_LOCATION,
+			g_param_spec_string("timeshift-location", "Timeshift location",
+					"Directory of the timeshift files, on a disk rather than a tmpfs (NULL = user cache directory)", NULL,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_KEEP_AUDIO_PAD,
+			g_param_spec_boolean("keep-audio-pad", "Keep audio pad",
+					"Keep the audio pad linked during trick play and send GAP events on it instead of removing it", FALSE,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_STARTUP_QUEUE_BYTES,
+			g_param_spec_uint64("startup-queue-bytes", "Startup queue bytes",
+					"Bytes of fragments queued while the src pads come up instead of blocking the fetcher (0 = disabled)",
+					0, G_MAXUINT64, 0, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+	g_object_class_install_property(gobject_class, PROP_CHUNK_SIZE,
+			g_param_spec_uint("chunk-size", "Chunk size",
+					"Maximum bytes per pushed buffer (0 = chosen per container format)", 0, G_MAXUINT, 0,
+					(GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+	/**
+	 * GstAamp::set-buffer-release-func:
+	 * @func: a GstAampBufferReleaseFunc, void (*)(const void *ptr, gpointer user_data), or NULL
+	 * @user_data: passed to @func
+	 *
+	 * Setting a release function switches the raw Send() path to zero-copy: fragments are
+	 * wrapped instead of copied and must stay valid until @func is called with the pointer
+	 * given to Send(). NULL goes back to copying.
+	 */
+	gst_aamp_signals[SIGNAL_SET_BUFFER_RELEASE_FUNC] = g_signal_new("set-buffer-release-func",
+			G_TYPE_FROM_CLASS(klass), (GSignalFlags)(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+			G_STRUCT_OFFSET(GstAampClass, set_buffer_release_func), NULL, NULL, NULL,
+			G_TYPE_NONE, 2, G_TYPE_POINTER, G_TYPE_POINTER);
+	klass->set_buffer_release_func = gst_aamp_set_buffer_release_func;
+
+	/**
+	 * GstAamp::standby-add:
+	 * @uri: uri to tune in the background
+	 *
+	 * Tune @uri on a standby instance that buffers a few fragments and is handed to the next
+	 * aamp element going to READY with the same location. The pool is plugin wide, adding
+	 * beyond its size drops the oldest instance.
+	 */
+	gst_aamp_signals[SIGNAL_STANDBY_ADD] = g_signal_new("standby-add",
+			G_TYPE_FROM_CLASS(klass), (GSignalFlags)(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+			G_STRUCT_OFFSET(GstAampClass, standby_add), NULL, NULL, NULL,
+			G_TYPE_NONE, 1, G_TYPE_STRING);
+	klass->standby_add = gst_aamp_standby_add;
+
+	/**
+	 * GstAamp::standby-remove:
+	 * @uri: uri of the standby instance to drop, or NULL to drop them all
+	 */
+	gst_aamp_signals[SIGNAL_STANDBY_REMOVE] = g_signal_new("standby-remove",
+			G_TYPE_FROM_CLASS(klass), (GSignalFlags)(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+			G_STRUCT_OFFSET(GstAampClass, standby_remove), NULL, NULL, NULL,
+			G_TYPE_NONE, 1, G_TYPE_STRING);
+	klass->standby_remove = gst_aamp_standby_remove;
+
+	/**
+	 * GstAamp::standby-set-size:
+	 * @size: standby instances kept, 0 disables the pool
+	 */
+	gst_aamp_signals[SIGNAL_STANDBY_SET_SIZE] = g_signal_new("standby-set-size",
+			G_TYPE_FROM_CLASS(klass), (GSignalFlags)(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+			G_STRUCT_OFFSET(GstAampClass, standby_set_size), NULL, NULL, NULL,
+			G_TYPE_NONE, 1, G_TYPE_UINT);
+	klass->standby_set_size = gst_aamp_standby_set_size;
+
 	gobject_class->finalize = gst_aamp_finalize;
 	element_class->change_state = GST_DEBUG_FUNCPTR(gst_aamp_change_state);
 	element_class->query = GST_DEBUG_FUNCPTR(gst_aamp_query);
@@ -768,17 +3165,373 @@ static void gst_aamp_init(GstAamp * aamp)
 	aamp->sinkpad = gst_pad_new_from_static_template(&gst_aamp_sink_template_hls, "sink");
 	memset(&aamp->stream[0], 0 , sizeof(aamp->stream));
 	aamp->stream_id = NULL;
-	aamp->idle_id = 0;
+	aamp->tune_bus = NULL;
+	aamp->tune_handler = 0;
+	aamp->tune_pending = 0;
+	aamp->retune_pending = 0;
+	aamp->tune_pipeline = NULL;
+	aamp->release_func = NULL;
+	aamp->release_data = NULL;
+	aamp->push_buffer_list = FALSE;
+	aamp->chunk_size = 0;
+	aamp->async_push = FALSE;
+	aamp->ring_depth = AAMP_DEFAULT_RING_DEPTH;
+	aamp->max_inflight_bytes = 0;
+	aamp->max_inflight_time = 0;
+	aamp->split_access_units = FALSE;
+	aamp->interleave_window = 0;
+	aamp->seek_cache_time = 0;
+	aamp->seek_cache_bytes = 0;
+	aamp->timeshift_size = 0;
+	aamp->timeshift_location = NULL;
+	aamp->keep_audio_pad = FALSE;
+	aamp->startup_queue_bytes = 0;
+	memset(aamp->tune_times, 0, sizeof(aamp->tune_times));
+	aamp->tune_marked = 0;
+	aamp->tune_stats = NULL;
+	aamp->audio_gap = 0;
+	aamp->local_seek = 0;
+	aamp->position_query_busy = 0;
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		aamp->stream[i].pushedTime = GST_CLOCK_TIME_NONE;
+		aamp->stream[i].stats.lastPts = GST_CLOCK_TIME_NONE;
+		g_mutex_init(&aamp->stream[i].stats.lock);
+		aamp->stream[i].cache = gst_aamp_cache_new();
+		g_mutex_init(&aamp->stream[i].sendMutex);
+	}
 
 	gst_pad_set_chain_function(aamp->sinkpad, GST_DEBUG_FUNCPTR(gst_aamp_sink_chain));
 	gst_pad_set_event_function(aamp->sinkpad, GST_DEBUG_FUNCPTR(gst_aamp_sink_event));
 	gst_element_add_pad(GST_ELEMENT(aamp), aamp->sinkpad);
 	g_mutex_init (&aamp->mutex);
 	g_cond_init (&aamp->state_changed);
+	g_cond_init (&aamp->budget_changed);
+	g_cond_init (&aamp->work_changed);
 	aamp->context->Discontinuity(eMEDIATYPE_VIDEO);
 	aamp->context->Discontinuity(eMEDIATYPE_AUDIO);
 }
 
+/**
+ * @brief Tune uri on the running player, keeping the src pads and the decoders behind them
+ *
+ * The rate goes back to 1x first, so an audio pad dropped for trick play is back in place
+ * and flushed with the video pad. The pads are flushed as for a seek, which also unblocks
+ * a Send() waiting on downstream and drops what their rings still hold, and marked so the
+ * flush the player asks for on tune only sends the new segment. Caps and stream-start
+ * only go out again if the new content has another format.
+ */
+static void gst_aamp_retune(GstAamp * aamp, const gchar *uri)
+{
+	GST_INFO_OBJECT(aamp, "Retuning in place to %s", uri);
+	if (aamp->rate != 1.0F)
+	{
+		aamp->context->UpdateRate(1.0);
+		g_mutex_lock(&aamp->mutex);
+		aamp->rate = 1.0F;
+		g_mutex_unlock(&aamp->mutex);
+		gst_aamp_update_audio_src_pad(aamp);
+	}
+
+	g_mutex_lock(&aamp->mutex);
+	gboolean padsActive = (aamp->state == GST_AAMP_READY);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream* stream = &aamp->stream[i];
+		gst_aamp_inflight_clear(stream);
+		stream->pushedTime = GST_CLOCK_TIME_NONE;
+		gst_aamp_cache_clear(stream->cache);
+		if (stream->timeshift)
+		{
+			gst_aamp_timeshift_clear(stream->timeshift);
+		}
+		if (padsActive && stream->srcpad && ((i != eMEDIATYPE_AUDIO) || aamp->audio_enabled))
+		{
+			g_atomic_int_set(&stream->seekFlushed, 1);
+		}
+	}
+	aamp->local_seek = 0;
+	g_cond_broadcast(&aamp->budget_changed);
+	g_mutex_unlock(&aamp->mutex);
+	aamp->context->ClearStartupQueue();
+
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream* stream = &aamp->stream[i];
+		if (g_atomic_int_get(&stream->seekFlushed) && stream->srcpad)
+		{
+			gst_aamp_src_seek_flush(aamp, stream, GST_CLOCK_TIME_NONE);
+		}
+		g_atomic_int_set(&stream->eos, 0);
+		g_atomic_int_or(&stream->pendingEvents, AAMP_EVENT_RESET_POSITION);
+	}
+	/* Reset once the pads are flushed, buffers of the old content do not count for the new tune */
+	gst_aamp_tune_reset(aamp);
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_START);
+	if (GST_STATE(aamp) == GST_STATE_PLAYING)
+	{
+		g_atomic_int_set(&aamp->retune_pending, 1);
+	}
+	else
+	{
+		aamp->report_tune = TRUE;
+	}
+	GST_AAMP_LOG_TIMING("Calling aamp->Tune()\n");
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_CALLED);
+	aamp->player_aamp->Tune(uri);
+}
+
+/**
+ * @brief Store the uri to tune, and tune it right away if a tune is already running
+ */
+static void gst_aamp_set_location(GstAamp * aamp, const gchar *uri)
+{
+	g_mutex_lock(&aamp->mutex);
+	gboolean changed = (g_strcmp0(aamp->location, uri) != 0);
+	gboolean retune = changed && uri && ((aamp->state == GST_AAMP_CONFIGURED) || (aamp->state == GST_AAMP_READY));
+	if (changed)
+	{
+		g_free(aamp->location);
+		aamp->location = g_strdup(uri);
+	}
+	g_mutex_unlock(&aamp->mutex);
+	if (retune)
+	{
+		gst_aamp_retune(aamp, uri);
+	}
+}
+
+void gst_aamp_set_property(GObject * object, guint property_id, const GValue * value, GParamSpec * pspec)
+{
+	GstAamp *aamp = GST_AAMP(object);
+
+	switch (property_id)
+	{
+		case PROP_PUSH_BUFFER_LIST:
+			aamp->push_buffer_list = g_value_get_boolean(value);
+			break;
+		case PROP_CHUNK_SIZE:
+			aamp->chunk_size = g_value_get_uint(value);
+			break;
+		case PROP_SPLIT_ACCESS_UNITS:
+			aamp->split_access_units = g_value_get_boolean(value);
+			break;
+		case PROP_INTERLEAVE_WINDOW:
+			g_mutex_lock(&aamp->mutex);
+			aamp->interleave_window = g_value_get_uint64(value);
+			g_cond_broadcast(&aamp->budget_changed);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		case PROP_SEEK_CACHE_TIME:
+			aamp->seek_cache_time = g_value_get_uint64(value);
+			break;
+		case PROP_SEEK_CACHE_BYTES:
+			aamp->seek_cache_bytes = g_value_get_uint64(value);
+			break;
+		case PROP_TIMESHIFT_SIZE:
+			aamp->timeshift_size = g_value_get_uint64(value);
+			break;
+		case PROP_TIMESHIFT_LOCATION:
+			g_free(aamp->timeshift_location);
+			aamp->timeshift_location = g_value_dup_string(value);
+			break;
+		case PROP_KEEP_AUDIO_PAD:
+			aamp->keep_audio_pad = g_value_get_boolean(value);
+			break;
+		case PROP_LOCATION:
+			gst_aamp_set_location(aamp, g_value_get_string(value));
+			break;
+		case PROP_STARTUP_QUEUE_BYTES:
+			g_mutex_lock(&aamp->mutex);
+			aamp->startup_queue_bytes = g_value_get_uint64(value);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		case PROP_ASYNC_PUSH:
+			aamp->async_push = g_value_get_boolean(value);
+			break;
+		case PROP_RING_DEPTH:
+			aamp->ring_depth = g_value_get_uint(value);
+			break;
+		case PROP_MAX_INFLIGHT_BYTES:
+			g_mutex_lock(&aamp->mutex);
+			aamp->max_inflight_bytes = g_value_get_uint64(value);
+			g_cond_broadcast(&aamp->budget_changed);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		case PROP_MAX_INFLIGHT_TIME:
+			g_mutex_lock(&aamp->mutex);
+			aamp->max_inflight_time = g_value_get_uint64(value);
+			g_cond_broadcast(&aamp->budget_changed);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+			break;
+	}
+}
+
+/**
+ * @brief Add the push statistics of a track to stats, as fields prefixed with the track name
+ */
+static void gst_aamp_stats_add_track(GstStructure *stats, media_stream *stream, const gchar *track)
+{
+	GstAampPadStats *padStats = &stream->stats;
+	g_mutex_lock(&padStats->lock);
+	guint64 bytes = padStats->bytes;
+	guint64 blockedTime = padStats->blockedTime;
+	GstClockTime lastPts = padStats->lastPts;
+	g_mutex_unlock(&padStats->lock);
+	guint buffers = (guint) g_atomic_int_get(&padStats->buffers);
+	guint fragments = (guint) g_atomic_int_get(&padStats->fragments);
+	struct
+	{
+		const gchar *name;
+		GType type;
+		guint64 value;
+	} fields[] =
+	{
+		{ "buffers", G_TYPE_UINT, buffers },
+		{ "bytes", G_TYPE_UINT64, bytes },
+		{ "fragments", G_TYPE_UINT, fragments },
+		{ "push-blocked-time", G_TYPE_UINT64, blockedTime },
+		{ "flow-not-linked", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flowNotLinked) },
+		{ "flow-flushing", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flowFlushing) },
+		{ "flow-eos", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flowEos) },
+		{ "flow-not-negotiated", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flowNotNegotiated) },
+		{ "flow-error", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flowError) },
+		{ "discontinuities", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->discontinuities) },
+		{ "flushes", G_TYPE_UINT, (guint) g_atomic_int_get(&padStats->flushes) },
+		{ "last-pts", G_TYPE_UINT64, lastPts },
+	};
+	for (guint i = 0; i < G_N_ELEMENTS(fields); i++)
+	{
+		gchar *name = g_strdup_printf("%s-%s", track, fields[i].name);
+		if (fields[i].type == G_TYPE_UINT)
+		{
+			gst_structure_set(stats, name, G_TYPE_UINT, (guint) fields[i].value, NULL);
+		}
+		else
+		{
+			gst_structure_set(stats, name, G_TYPE_UINT64, fields[i].value, NULL);
+		}
+		g_free(name);
+	}
+	gchar *name = g_strdup_printf("%s-chunks-per-fragment", track);
+	gst_structure_set(stats, name, G_TYPE_DOUBLE, fragments ? (gdouble) buffers / fragments : 0.0, NULL);
+	g_free(name);
+}
+
+void gst_aamp_get_property(GObject * object, guint property_id, GValue * value, GParamSpec * pspec)
+{
+	GstAamp *aamp = GST_AAMP(object);
+
+	switch (property_id)
+	{
+		case PROP_PUSH_BUFFER_LIST:
+			g_value_set_boolean(value, aamp->push_buffer_list);
+			break;
+		case PROP_CHUNK_SIZE:
+			g_value_set_uint(value, aamp->chunk_size);
+			break;
+		case PROP_SPLIT_ACCESS_UNITS:
+			g_value_set_boolean(value, aamp->split_access_units);
+			break;
+		case PROP_INTERLEAVE_WINDOW:
+			g_value_set_uint64(value, aamp->interleave_window);
+			break;
+		case PROP_SEEK_CACHE_TIME:
+			g_value_set_uint64(value, aamp->seek_cache_time);
+			break;
+		case PROP_SEEK_CACHE_BYTES:
+			g_value_set_uint64(value, aamp->seek_cache_bytes);
+			break;
+		case PROP_TIMESHIFT_SIZE:
+			g_value_set_uint64(value, aamp->timeshift_size);
+			break;
+		case PROP_TIMESHIFT_LOCATION:
+			g_value_set_string(value, aamp->timeshift_location);
+			break;
+		case PROP_KEEP_AUDIO_PAD:
+			g_value_set_boolean(value, aamp->keep_audio_pad);
+			break;
+		case PROP_STARTUP_QUEUE_BYTES:
+			g_value_set_uint64(value, aamp->startup_queue_bytes);
+			break;
+		case PROP_LOCATION:
+			g_mutex_lock(&aamp->mutex);
+			g_value_set_string(value, aamp->location);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		case PROP_TUNE_TIMES:
+			g_mutex_lock(&aamp->mutex);
+			g_value_set_boxed(value, aamp->tune_stats);
+			g_mutex_unlock(&aamp->mutex);
+			break;
+		case PROP_ASYNC_PUSH:
+			g_value_set_boolean(value, aamp->async_push);
+			break;
+		case PROP_RING_DEPTH:
+			g_value_set_uint(value, aamp->ring_depth);
+			break;
+		case PROP_MAX_INFLIGHT_BYTES:
+			g_value_set_uint64(value, aamp->max_inflight_bytes);
+			break;
+		case PROP_MAX_INFLIGHT_TIME:
+			g_value_set_uint64(value, aamp->max_inflight_time);
+			break;
+		case PROP_RING_STATS:
+		{
+			GstStructure *stats = gst_structure_new_empty("aamp-ring-stats");
+			g_mutex_lock(&aamp->mutex);
+			for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+			{
+				GstAampRing *ring = aamp->stream[i].ring;
+				const gchar *track = (i == eMEDIATYPE_AUDIO) ? "audio" : "video";
+				gchar *level = g_strdup_printf("%s-level", track);
+				gchar *blocked = g_strdup_printf("%s-blocked-time", track);
+				guint64 blockedTime = 0;
+				if (ring)
+				{
+					g_mutex_lock(&ring->mutex);
+					blockedTime = (guint64) ring->blockedTime * GST_USECOND;
+					g_mutex_unlock(&ring->mutex);
+				}
+				gst_structure_set(stats, level, G_TYPE_UINT, ring ? gst_aamp_ring_level(ring) : 0,
+						blocked, G_TYPE_UINT64, blockedTime, NULL);
+				g_free(level);
+				g_free(blocked);
+			}
+			g_mutex_unlock(&aamp->mutex);
+			g_value_take_boxed(value, stats);
+			break;
+		}
+		case PROP_STATS:
+		{
+			GstStructure *stats = gst_structure_new_empty("aamp-stats");
+			for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+			{
+				gst_aamp_stats_add_track(stats, &aamp->stream[i], (i == eMEDIATYPE_AUDIO) ? "audio" : "video");
+			}
+			g_value_take_boxed(value, stats);
+			break;
+		}
+		case PROP_POOL_STATS:
+		{
+			GstStructure *stats = gst_structure_new("aamp-pool-stats",
+					"video-hits", G_TYPE_UINT, (guint) g_atomic_int_get(&aamp->stream[eMEDIATYPE_VIDEO].poolHits),
+					"video-misses", G_TYPE_UINT, (guint) g_atomic_int_get(&aamp->stream[eMEDIATYPE_VIDEO].poolMisses),
+					"audio-hits", G_TYPE_UINT, (guint) g_atomic_int_get(&aamp->stream[eMEDIATYPE_AUDIO].poolHits),
+					"audio-misses", G_TYPE_UINT, (guint) g_atomic_int_get(&aamp->stream[eMEDIATYPE_AUDIO].poolMisses),
+					NULL);
+			g_value_take_boxed(value, stats);
+			break;
+		}
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+			break;
+	}
+}
+
 void gst_aamp_finalize(GObject * object)
 {
 	GstAamp *aamp = GST_AAMP(object);
@@ -788,11 +3541,18 @@ void gst_aamp_finalize(GObject * object)
 		g_free(aamp->location);
 		aamp->location = NULL;
 	}
+	g_free(aamp->timeshift_location);
+	if (aamp->tune_stats)
+	{
+		gst_structure_free(aamp->tune_stats);
+	}
 	g_mutex_clear (&aamp->mutex);
 	delete aamp->context;
 	aamp->context=NULL;
 	delete aamp->player_aamp;
 	g_cond_clear (&aamp->state_changed);
+	g_cond_clear (&aamp->budget_changed);
+	g_cond_clear (&aamp->work_changed);
 
 	if (aamp->stream[eMEDIATYPE_AUDIO].caps)
 	{
@@ -814,6 +3574,30 @@ void gst_aamp_finalize(GObject * object)
 		gst_object_unref(aamp->stream[eMEDIATYPE_AUDIO].srcpad);
 	}
 
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		if (aamp->stream[i].pool)
+		{
+			gst_object_unref(aamp->stream[i].pool);
+		}
+		if (aamp->stream[i].allocator)
+		{
+			gst_object_unref(aamp->stream[i].allocator);
+		}
+		gst_aamp_cache_free(aamp->stream[i].cache);
+		if (aamp->stream[i].timeshift)
+		{
+			gst_aamp_timeshift_free(aamp->stream[i].timeshift);
+		}
+		if (aamp->stream[i].ring)
+		{
+			gst_aamp_ring_free(aamp->stream[i].ring);
+		}
+		gst_aamp_inflight_clear(&aamp->stream[i]);
+		g_mutex_clear(&aamp->stream[i].sendMutex);
+		g_mutex_clear(&aamp->stream[i].stats.lock);
+	}
+
 	if (aamp->stream_id)
 	{
 		g_free(aamp->stream_id);
@@ -823,6 +3607,18 @@ void gst_aamp_finalize(GObject * object)
 	G_OBJECT_CLASS(gst_aamp_parent_class)->finalize(object);
 }
 
+/**
+ * @brief Class handler of the set-buffer-release-func action signal
+ */
+static void gst_aamp_set_buffer_release_func(GstAamp *aamp, gpointer func, gpointer user_data)
+{
+	g_mutex_lock(&aamp->mutex);
+	aamp->release_func = (GstAampBufferReleaseFunc) func;
+	aamp->release_data = user_data;
+	g_mutex_unlock(&aamp->mutex);
+	GST_INFO_OBJECT(aamp, "zero-copy send %s", func ? "enabled" : "disabled");
+}
+
 /**
  * @fn void aampClientCallback()
  * @brief This function receives asynchronous events from AAMP
@@ -908,6 +3704,7 @@ static void gst_aamp_tune_async(GstAamp *aamp)
 	aamp->state = GST_AAMP_TUNING;
 	g_mutex_unlock(&aamp->mutex);
 	GST_AAMP_LOG_TIMING("Calling aamp->Tune()\n");
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_CALLED);
 	aamp->player_aamp->Tune(aamp->location);
 }
 
@@ -937,32 +3734,381 @@ static gboolean gst_aamp_ready(GstAamp *aamp)
 	return ret;
 }
 
-static gboolean gst_aamp_report_on_tune_done(gpointer user_data)
+/* Plugin wide pool of elements tuned in the background, oldest first */
+static GMutex standby_mutex;
+static GQueue standby_queue = G_QUEUE_INIT;
+static guint standby_size = AAMP_STANDBY_DEFAULT_SIZE;
+
+/**
+ * @brief Stop the player of a standby element and drop it
+ *
+ * Its fetcher may wait for the pads, the state change wakes it before the player stops.
+ */
+static void gst_aamp_standby_stop(GstAamp *aamp)
+{
+	GST_INFO_OBJECT(aamp, "Dropping standby instance for %s", aamp->location);
+	g_mutex_lock(&aamp->mutex);
+	aamp->state = GST_AAMP_SHUTTING_DOWN;
+	g_cond_broadcast(&aamp->state_changed);
+	g_cond_broadcast(&aamp->budget_changed);
+	g_mutex_unlock(&aamp->mutex);
+	aamp->player_aamp->Stop();
+	aamp->player_aamp->RegisterEvents(NULL);
+	gst_object_unref(aamp);
+}
+
+/**
+ * @brief Class handler of the standby-add action signal
+ */
+static void gst_aamp_standby_add(GstAamp *element, const gchar *uri)
 {
-	GstAamp *aamp = (GstAamp *) user_data;
-	GstElement *pbin = GST_ELEMENT(aamp);
-	while (GST_ELEMENT_PARENT(pbin))
+	g_mutex_lock(&standby_mutex);
+	gboolean known = FALSE;
+	for (GList *link = standby_queue.head; link; link = link->next)
 	{
-		pbin = GST_ELEMENT_PARENT(pbin);
+		known = known || (g_strcmp0(GST_AAMP(link->data)->location, uri) == 0);
 	}
-	if (GST_STATE(pbin) == GST_STATE_PLAYING)
+	g_mutex_unlock(&standby_mutex);
+	if (known || (standby_size == 0))
 	{
-		GST_AAMP_LOG_TIMING("LogTuneComplete()");
-		aamp->player_aamp->aamp->LogTuneComplete();
-		aamp->idle_id = 0;
-		return G_SOURCE_REMOVE;
+		return;
 	}
-	else
+
+	GstAamp *aamp = GST_AAMP(g_object_new(GST_TYPE_AAMP, NULL));
+	gst_object_ref_sink(aamp);
+	aamp->location = g_strdup(uri);
+	aamp->startup_queue_bytes = AAMP_STANDBY_STARTUP_QUEUE_BYTES;
+	aamp->standby = TRUE;
+	GST_INFO_OBJECT(element, "Tuning standby instance %s for %s", GST_OBJECT_NAME(aamp), uri);
+	aamp->player_aamp->RegisterEvents(aamp->context);
+	gst_aamp_tune_async(aamp);
+
+	GQueue dropped = G_QUEUE_INIT;
+	g_mutex_lock(&standby_mutex);
+	g_queue_push_tail(&standby_queue, aamp);
+	while (standby_queue.length > standby_size)
+	{
+		g_queue_push_tail(&dropped, g_queue_pop_head(&standby_queue));
+	}
+	g_mutex_unlock(&standby_mutex);
+	while ((aamp = (GstAamp *) g_queue_pop_head(&dropped)) != NULL)
+	{
+		gst_aamp_standby_stop(aamp);
+	}
+}
+
+/**
+ * @brief Class handler of the standby-remove action signal
+ */
+static void gst_aamp_standby_remove(GstAamp *element, const gchar *uri)
+{
+	GQueue dropped = G_QUEUE_INIT;
+	g_mutex_lock(&standby_mutex);
+	GList *link = standby_queue.head;
+	while (link)
+	{
+		GList *next = link->next;
+		if (!uri || (g_strcmp0(GST_AAMP(link->data)->location, uri) == 0))
+		{
+			g_queue_push_tail(&dropped, link->data);
+			g_queue_delete_link(&standby_queue, link);
+		}
+		link = next;
+	}
+	g_mutex_unlock(&standby_mutex);
+	GstAamp *aamp;
+	while ((aamp = (GstAamp *) g_queue_pop_head(&dropped)) != NULL)
+	{
+		gst_aamp_standby_stop(aamp);
+	}
+}
+
+/**
+ * @brief Class handler of the standby-set-size action signal
+ */
+static void gst_aamp_standby_set_size(GstAamp *element, guint size)
+{
+	GST_INFO_OBJECT(element, "Standby pool size %u", size);
+	GQueue dropped = G_QUEUE_INIT;
+	g_mutex_lock(&standby_mutex);
+	standby_size = size;
+	while (standby_queue.length > standby_size)
+	{
+		g_queue_push_tail(&dropped, g_queue_pop_head(&standby_queue));
+	}
+	g_mutex_unlock(&standby_mutex);
+	GstAamp *aamp;
+	while ((aamp = (GstAamp *) g_queue_pop_head(&dropped)) != NULL)
+	{
+		gst_aamp_standby_stop(aamp);
+	}
+}
+
+/**
+ * @brief Remove the standby element tuned to uri from the pool, NULL if there is none
+ */
+static GstAamp* gst_aamp_standby_take(const gchar *uri)
+{
+	GstAamp *standby = NULL;
+	g_mutex_lock(&standby_mutex);
+	for (GList *link = standby_queue.head; link; link = link->next)
+	{
+		if (g_strcmp0(GST_AAMP(link->data)->location, uri) == 0)
+		{
+			standby = GST_AAMP(link->data);
+			g_queue_delete_link(&standby_queue, link);
+			break;
+		}
+	}
+	g_mutex_unlock(&standby_mutex);
+	return standby;
+}
+
+/**
+ * @brief Take over the player, streamer and src pads of a tuned standby element
+ *
+ * The standby element gets the untuned player of aamp in exchange and is dropped. The
+ * fragments its fetcher queued meanwhile are pushed once the pads of aamp are ready. The
+ * pads of an earlier tune of aamp are removed first, the ones taken over get their pools
+ * built again for the chunk size of aamp. The downloads it stopped resume with the tune.
+ */
+static gboolean gst_aamp_adopt_standby(GstAamp *aamp, GstAamp *standby)
+{
+	if (!gst_aamp_configured(standby))
+	{
+		GST_WARNING_OBJECT(aamp, "Standby instance for %s failed to tune", aamp->location);
+		gst_aamp_standby_stop(standby);
+		return FALSE;
+	}
+	/* The pads of an earlier tune are replaced by the ones of the standby element */
+	GstPad *oldPads[AAMP_TRACK_COUNT] = { NULL };
+	GstCaps *oldCaps[AAMP_TRACK_COUNT] = { NULL };
+#ifdef USE_GST1
+	GstBufferPool *stalePools[AAMP_TRACK_COUNT] = { NULL };
+	GstBufferPool *oldPools[AAMP_TRACK_COUNT] = { NULL };
+#endif
+	g_mutex_lock(&aamp->mutex);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream *stream = &aamp->stream[i];
+		oldPads[i] = stream->srcpad;
+		oldCaps[i] = stream->caps;
+		stream->srcpad = NULL;
+		stream->caps = NULL;
+#ifdef USE_GST1
+		oldPools[i] = stream->pool;
+		stream->pool = NULL;
+#endif
+	}
+	aamp->audio_enabled = FALSE;
+	g_mutex_unlock(&aamp->mutex);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		if (oldPads[i])
+		{
+			if ((GST_OBJECT_PARENT(oldPads[i]) == GST_OBJECT_CAST(aamp))
+					&& (FALSE == gst_element_remove_pad(GST_ELEMENT(aamp), oldPads[i])))
+			{
+				GST_WARNING_OBJECT(aamp, "gst_element_remove_pad %s:%s failed", GST_DEBUG_PAD_NAME(oldPads[i]));
+			}
+			gst_object_unref(oldPads[i]);
+		}
+		if (oldCaps[i])
+		{
+			gst_caps_unref(oldCaps[i]);
+		}
+#ifdef USE_GST1
+		if (oldPools[i])
+		{
+			gst_buffer_pool_set_active(oldPools[i], FALSE);
+			gst_object_unref(oldPools[i]);
+		}
+#endif
+	}
+
+	g_mutex_lock(&standby->mutex);
+	g_mutex_lock(&aamp->mutex);
+	GstAampStreamer *context = aamp->context;
+	PlayerInstanceAAMP *player = aamp->player_aamp;
+	aamp->context = standby->context;
+	aamp->player_aamp = standby->player_aamp;
+	standby->context = context;
+	standby->player_aamp = player;
+	aamp->context->SetElement(aamp);
+	standby->context->SetElement(standby);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream *from = &standby->stream[i];
+		media_stream *to = &aamp->stream[i];
+		to->srcpad = from->srcpad;
+		to->caps = from->caps;
+		to->format = from->format;
+		to->padSerial = from->padSerial;
+		g_atomic_int_or(&to->pendingEvents, g_atomic_int_get(&from->pendingEvents));
+#ifdef USE_GST1
+		/* Sized for the chunk size of the standby element, not the one set on aamp */
+		stalePools[i] = from->pool;
+		if (to->caps)
+		{
+			to->poolBufferSize = gst_aamp_get_pool_buffer_size(aamp, (StreamOutputFormat) to->format);
+			to->pool = gst_aamp_create_buffer_pool(aamp, to->caps, to->poolBufferSize);
+		}
+#endif
+		from->srcpad = NULL;
+		from->caps = NULL;
+		from->pool = NULL;
+	}
+	gchar *streamId = aamp->stream_id;
+	aamp->stream_id = standby->stream_id;
+	standby->stream_id = streamId;
+	aamp->state = standby->state;
+	standby->state = GST_AAMP_SHUTTING_DOWN;
+	g_cond_broadcast(&standby->state_changed);
+	g_mutex_unlock(&aamp->mutex);
+	g_mutex_unlock(&standby->mutex);
+#ifdef USE_GST1
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		if (stalePools[i])
+		{
+			gst_object_unref(stalePools[i]);
+		}
+	}
+#endif
+	GST_INFO_OBJECT(aamp, "Took over standby instance for %s", aamp->location);
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_CALLED);
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_CONFIGURED);
+	/* The player given away was registered with its streamer but never tuned */
+	standby->player_aamp->RegisterEvents(NULL);
+	/* A fetcher still waiting on the standby element holds its own reference */
+	gst_object_unref(standby);
+	return TRUE;
+}
+
+/**
+ * @brief Post the tune milestones as an aamp-tune-times element message and keep them
+ * for the tune-times property
+ *
+ * Fields are in microseconds from the start of the tune, -1 for milestones not reached.
+ */
+static void gst_aamp_post_tune_times(GstAamp * aamp)
+{
+	gint64 times[GST_AAMP_TUNE_MILESTONE_COUNT];
+	g_mutex_lock(&aamp->mutex);
+	memcpy(times, aamp->tune_times, sizeof(times));
+	g_mutex_unlock(&aamp->mutex);
+	GstStructure *stats = gst_structure_new_empty("aamp-tune-times");
+	gint64 start = times[GST_AAMP_TUNE_START];
+	for (int i = GST_AAMP_TUNE_CALLED; i < GST_AAMP_TUNE_MILESTONE_COUNT; i++)
+	{
+		gint64 time = times[i];
+		gst_structure_set(stats, gst_aamp_tune_milestone_names[i], G_TYPE_INT64,
+				(time && start) ? (time - start) : (gint64) -1, NULL);
+	}
+	GST_INFO_OBJECT(aamp, "Tune times %" GST_PTR_FORMAT, stats);
+	g_mutex_lock(&aamp->mutex);
+	if (aamp->tune_stats)
+	{
+		gst_structure_free(aamp->tune_stats);
+	}
+	aamp->tune_stats = gst_structure_copy(stats);
+	g_mutex_unlock(&aamp->mutex);
+	gst_element_post_message(GST_ELEMENT(aamp), gst_message_new_element(GST_OBJECT(aamp), stats));
+}
+
+/**
+ * @brief Report the tune complete
+ */
+static void gst_aamp_tune_done(GstAamp * aamp)
+{
+	gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_PLAYING);
+	GST_AAMP_LOG_TIMING("LogTuneComplete()");
+	aamp->player_aamp->aamp->LogTuneComplete();
+	gst_aamp_post_tune_times(aamp);
+}
+
+/**
+ * @brief Report the tune complete, once per tune, whichever thread sees PLAYING first
+ */
+static void gst_aamp_report_on_tune_done(GstAamp * aamp)
+{
+	if (g_atomic_int_compare_and_exchange(&aamp->tune_pending, 1, 0))
+	{
+		gst_aamp_tune_done(aamp);
+	}
+}
+
+/**
+ * @brief Bus sync handler, runs on the thread that completes the state change of the
+ * top-level pipeline
+ */
+static void gst_aamp_on_state_changed(GstBus * bus, GstMessage * message, gpointer user_data)
+{
+	GstAamp *aamp = GST_AAMP(user_data);
+	if (g_atomic_int_get(&aamp->tune_pending) && (GST_MESSAGE_SRC(message) == GST_OBJECT_CAST(aamp->tune_pipeline)))
+	{
+		GstState oldState, newState, pending;
+		gst_message_parse_state_changed(message, &oldState, &newState, &pending);
+		if (newState == GST_STATE_PLAYING)
+		{
+			gst_aamp_report_on_tune_done(aamp);
+		}
+	}
+}
+
+/**
+ * @brief Wait for the top-level pipeline to reach PLAYING to report the tune complete
+ *
+ * The state-changed message of the pipeline is caught as it is posted, the reported time
+ * is when it got there and nothing runs until then.
+ */
+static void gst_aamp_watch_tune_done(GstAamp * aamp)
+{
+	GstElement *pipeline = GST_ELEMENT(aamp);
+	while (GST_ELEMENT_PARENT(pipeline))
+	{
+		pipeline = GST_ELEMENT_PARENT(pipeline);
+	}
+	g_atomic_int_set(&aamp->tune_pending, 1);
+	aamp->tune_pipeline = pipeline;
+	GstBus *bus = (pipeline != GST_ELEMENT(aamp)) ? gst_element_get_bus(pipeline) : NULL;
+	if (bus)
+	{
+		gst_bus_enable_sync_message_emission(bus);
+		aamp->tune_handler = g_signal_connect(bus, "sync-message::state-changed", G_CALLBACK(gst_aamp_on_state_changed), aamp);
+		aamp->tune_bus = bus;
+	}
+	/* Without a pipeline, or when added to one that already plays, PLAYING is now */
+	if (!bus || ((GST_STATE(pipeline) == GST_STATE_PLAYING) && (GST_STATE_PENDING(pipeline) == GST_STATE_VOID_PENDING)))
+	{
+		gst_aamp_report_on_tune_done(aamp);
+	}
+}
+
+static void gst_aamp_unwatch_tune_done(GstAamp * aamp)
+{
+	g_atomic_int_set(&aamp->tune_pending, 0);
+	if (g_atomic_int_compare_and_exchange(&aamp->retune_pending, 1, 0))
+	{
+		/* Paused before the retune played, it is reported once playing again */
+		aamp->report_tune = TRUE;
+	}
+	if (aamp->tune_bus)
 	{
-		GST_DEBUG_OBJECT(aamp, "Pipeline Not yet playing");
-		return G_SOURCE_CONTINUE;
+		g_signal_handler_disconnect(aamp->tune_bus, aamp->tune_handler);
+		gst_bus_disable_sync_message_emission(aamp->tune_bus);
+		gst_object_unref(aamp->tune_bus);
+		aamp->tune_bus = NULL;
+		aamp->tune_handler = 0;
 	}
+	aamp->tune_pipeline = NULL;
 }
 
 static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstStateChange trans)
 {
 	GstAamp *aamp;
 	GstStateChangeReturn ret;
+	gboolean tuned = FALSE;
 
 	aamp = GST_AAMP(element);
 	GST_DEBUG_OBJECT(aamp, "Enter");
@@ -971,11 +4117,18 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 	{
 		case GST_STATE_CHANGE_NULL_TO_READY:
 			GST_AAMP_LOG_TIMING("GST_STATE_CHANGE_NULL_TO_READY");
+			gst_aamp_tune_reset(aamp);
+			gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_START);
 			aamp->player_aamp->RegisterEvents(aamp->context);
-			if ( FALSE == gst_aamp_query_uri( aamp) )
+			/* A location set by the application wins over the upstream uri */
+			if ( !aamp->location && (FALSE == gst_aamp_query_uri( aamp)) )
 			{
 				return GST_STATE_CHANGE_FAILURE;
 			}
+			{
+				GstAamp *standby = gst_aamp_standby_take(aamp->location);
+				tuned = standby && gst_aamp_adopt_standby(aamp, standby);
+			}
 #ifdef AAMP_JSCONTROLLER_ENABLED
 			{
 				int sessionId = 0;
@@ -990,7 +4143,10 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 				setAAMPPlayerInstance(aamp->player_aamp, sessionId);
 			}
 #endif
-			gst_aamp_tune_async( aamp);
+			if (!tuned)
+			{
+				gst_aamp_tune_async( aamp);
+			}
 			aamp->report_tune = TRUE;
 			aamp->player_aamp->aamp->ResumeTrackDownloads(eMEDIATYPE_VIDEO);
 			aamp->player_aamp->aamp->ResumeTrackDownloads(eMEDIATYPE_AUDIO);
@@ -999,24 +4155,44 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 		case GST_STATE_CHANGE_READY_TO_PAUSED:
 			GST_AAMP_LOG_TIMING("GST_STATE_CHANGE_READY_TO_PAUSED\n");
 			g_mutex_lock (&aamp->mutex);
+			aamp->timeshift_pending = aamp->timeshift_size && aamp->player_aamp->aamp->IsLive();
+			if (aamp->async_push)
+			{
+				for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+				{
+					if (aamp->stream[i].srcpad && !aamp->stream[i].ring)
+					{
+						aamp->stream[i].ring = gst_aamp_ring_new(aamp->ring_depth);
+					}
+				}
+			}
 			if (NULL != aamp->stream[eMEDIATYPE_VIDEO].srcpad)
 			{
 				if (FALSE == gst_pad_set_active (aamp->stream[eMEDIATYPE_VIDEO].srcpad, TRUE))
 				{
 					GST_WARNING_OBJECT(aamp, "gst_pad_set_active failed");
 				}
-				if (FALSE == gst_element_add_pad(GST_ELEMENT(aamp), aamp->stream[eMEDIATYPE_VIDEO].srcpad))
+				/* A pad reused from an earlier tune is still added */
+				if ((GST_OBJECT_PARENT(aamp->stream[eMEDIATYPE_VIDEO].srcpad) != GST_OBJECT_CAST(element))
+						&& (FALSE == gst_element_add_pad(GST_ELEMENT(aamp), aamp->stream[eMEDIATYPE_VIDEO].srcpad)))
 				{
 					GST_WARNING_OBJECT(aamp, "gst_element_add_pad srcpad failed");
 				}
-				aamp->stream[eMEDIATYPE_VIDEO].streamStart = TRUE;
-				aamp->stream[eMEDIATYPE_VIDEO].eventsPending = TRUE;
+				g_atomic_int_or(&aamp->stream[eMEDIATYPE_VIDEO].pendingEvents, AAMP_EVENT_STREAM_START);
+				gst_aamp_start_push_task(aamp, &aamp->stream[eMEDIATYPE_VIDEO]);
 			}
+			g_mutex_unlock (&aamp->mutex);
 			gst_aamp_update_audio_src_pad(aamp);
+			g_mutex_lock (&aamp->mutex);
+#ifdef USE_GST1
+			gst_aamp_set_buffer_pools_active(aamp, TRUE);
+#endif
 			aamp->state = GST_AAMP_READY;
 			g_cond_signal(&aamp->state_changed);
+			gst_aamp_start_workers(aamp);
 			g_mutex_unlock (&aamp->mutex);
 			gst_element_no_more_pads (element);
+			gst_aamp_tune_mark(aamp, GST_AAMP_TUNE_PADS_EXPOSED);
 			break;
 		case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
 			GST_AAMP_LOG_TIMING("GST_STATE_CHANGE_PAUSED_TO_PLAYING\n");
@@ -1025,7 +4201,7 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 #endif
 			if (aamp->report_tune)
 			{
-				aamp->idle_id = g_timeout_add(50, gst_aamp_report_on_tune_done, aamp);
+				gst_aamp_watch_tune_done(aamp);
 				aamp->report_tune = FALSE;
 			}
 			break;
@@ -1048,20 +4224,47 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 	switch (trans)
 	{
 		case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
-			if (aamp->idle_id)
-			{
-				g_source_remove(aamp->idle_id);
-				aamp->idle_id = 0;
-			}
+			gst_aamp_unwatch_tune_done(aamp);
 			GST_DEBUG_OBJECT(aamp, "GST_STATE_CHANGE_PLAYING_TO_PAUSED");
 			break;
 		case GST_STATE_CHANGE_PAUSED_TO_READY:
 			GST_DEBUG_OBJECT(aamp, "GST_STATE_CHANGE_PAUSED_TO_READY");
 			g_mutex_lock(&aamp->mutex);
 			aamp->state = GST_AAMP_SHUTTING_DOWN;
+			aamp->timeshift_pending = FALSE;
 			g_cond_signal(&aamp->state_changed);
+			g_cond_broadcast(&aamp->budget_changed);
+			g_cond_broadcast(&aamp->work_changed);
 			g_mutex_unlock(&aamp->mutex);
 			aamp->player_aamp->Stop();
+			aamp->context->ClearStartupQueue();
+			gst_aamp_stop_workers(aamp);
+			/* The pad tasks were stopped as the parent class deactivated the pads */
+			g_mutex_lock(&aamp->mutex);
+			for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+			{
+				media_stream* stream = &aamp->stream[i];
+				gst_aamp_inflight_clear(stream);
+				gst_aamp_cache_clear(stream->cache);
+				stream->seekFlushed = 0;
+				stream->eos = 0;
+				if (stream->timeshift)
+				{
+					gst_aamp_timeshift_free(stream->timeshift);
+					stream->timeshift = NULL;
+				}
+				aamp->local_seek = 0;
+				if (stream->ring)
+				{
+					GST_INFO_OBJECT(aamp, "track %d producer blocked %" G_GINT64_FORMAT " us on full ring", i, stream->ring->blockedTime);
+					gst_aamp_ring_free(stream->ring);
+					stream->ring = NULL;
+				}
+			}
+			g_mutex_unlock(&aamp->mutex);
+#ifdef USE_GST1
+			gst_aamp_set_buffer_pools_active(aamp, FALSE);
+#endif
 #ifdef AAMP_CC_ENABLED
 			gst_aamp_cc_stop(aamp);
 #endif
@@ -1069,6 +4272,7 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 		case GST_STATE_CHANGE_READY_TO_NULL:
 			GST_DEBUG_OBJECT(aamp, "GST_STATE_CHANGE_READY_TO_NULL");
 			aamp->player_aamp->RegisterEvents(NULL);
+			aamp->context->ClearStartupQueue();
 #ifdef AAMP_JSCONTROLLER_ENABLED
 			unsetAAMPPlayerInstance(aamp->player_aamp);
 #endif
@@ -1100,6 +4304,32 @@ static GstStateChangeReturn gst_aamp_change_state(GstElement * element, GstState
 	return ret;
 }
 
+/**
+ * @brief Playback position in ns
+ *
+ * The player does not know about seeks served from the seek cache, nor how far playback
+ * from a timeshift file lags its downloads, the position then comes from downstream. The busy flag stops a sink that forwards the query upstream
+ * from coming back here.
+ */
+static gint64 gst_aamp_get_position(GstAamp * aamp)
+{
+#ifdef USE_GST1
+	GstPad *srcpad = aamp->stream[eMEDIATYPE_VIDEO].srcpad;
+	if ((g_atomic_int_get(&aamp->local_seek) || aamp->stream[eMEDIATYPE_VIDEO].timeshift) && srcpad
+			&& g_atomic_int_compare_and_exchange(&aamp->position_query_busy, 0, 1))
+	{
+		gint64 position = -1;
+		gboolean ret = gst_pad_peer_query_position(srcpad, GST_FORMAT_TIME, &position);
+		g_atomic_int_set(&aamp->position_query_busy, 0);
+		if (ret && position >= 0)
+		{
+			return position;
+		}
+	}
+#endif
+	return aamp->player_aamp->aamp->GetPositionMs() * GST_MSECOND;
+}
+
 static gboolean gst_aamp_query(GstElement * element, GstQuery * query)
 {
 	GstAamp *aamp = GST_AAMP(element);
@@ -1116,7 +4346,7 @@ static gboolean gst_aamp_query(GstElement * element, GstQuery * query)
 			gst_query_parse_position(query, &format, NULL);
 			if (format == GST_FORMAT_TIME)
 			{
-				gst_query_set_position(query, GST_FORMAT_TIME, (aamp->player_aamp->aamp->GetPositionMs()*GST_MSECOND));
+				gst_query_set_position(query, GST_FORMAT_TIME, gst_aamp_get_position(aamp));
 				ret = TRUE;
 			}
 			break;
@@ -1211,21 +4441,27 @@ static gboolean gst_aamp_src_query(GstPad * pad, GstObject *parent, GstQuery * q
 	{
 		case GST_QUERY_CAPS:
 		{
-			GstCaps* caps;
-			if(aamp->stream[eMEDIATYPE_VIDEO].srcpad == pad )
+			GstCaps* caps = NULL;
+			g_mutex_lock(&aamp->mutex);
+			for (int i = 0; i < AAMP_TRACK_COUNT; i++)
 			{
-				caps = aamp->stream[eMEDIATYPE_VIDEO].caps;
+				if ((aamp->stream[i].srcpad == pad) && aamp->stream[i].caps)
+				{
+					caps = gst_caps_ref(aamp->stream[i].caps);
+				}
 			}
-			else if(aamp->stream[eMEDIATYPE_AUDIO].srcpad == pad )
+			g_mutex_unlock(&aamp->mutex);
+			if (caps)
 			{
-				caps = aamp->stream[eMEDIATYPE_AUDIO].caps;
+				gst_query_set_caps_result(query, caps);
+				gst_caps_unref(caps);
+				ret = TRUE;
 			}
 			else
 			{
+				/* A pad replaced on a format change, until it is removed */
 				GST_WARNING_OBJECT(aamp, "Unknown pad %p", pad);
 			}
-			gst_query_set_caps_result(query, caps);
-			ret = TRUE;
 			break;
 		}
 		case GST_QUERY_POSITION:
@@ -1235,9 +4471,9 @@ static gboolean gst_aamp_src_query(GstPad * pad, GstObject *parent, GstQuery * q
 			gst_query_parse_position(query, &format, NULL);
 			if (format == GST_FORMAT_TIME)
 			{
-				gint64 posMs = aamp->player_aamp->aamp->GetPositionMs();
-				GST_TRACE_OBJECT(aamp, " GST_QUERY_POSITION position %" G_GUINT64_FORMAT " seconds\n", posMs/1000);
-				gst_query_set_position(query, GST_FORMAT_TIME, (posMs*GST_MSECOND ));
+				gint64 position = gst_aamp_get_position(aamp);
+				GST_TRACE_OBJECT(aamp, " GST_QUERY_POSITION position %" G_GUINT64_FORMAT " seconds\n", position/GST_SECOND);
+				gst_query_set_position(query, GST_FORMAT_TIME, position);
 				ret = TRUE;
 			}
 			break;
@@ -1297,6 +4533,32 @@ static gboolean gst_aamp_src_query(GstPad * pad, GstObject *parent, GstQuery * q
 	return ret;
 }
 
+/**
+ * @brief TRUE if every active track has position in its seek cache or timeshift file
+ */
+static gboolean gst_aamp_seek_cached(GstAamp * aamp, gint64 position)
+{
+	if (!(aamp->seek_cache_time || aamp->seek_cache_bytes || aamp->timeshift_size) || (position < 0))
+	{
+		return FALSE;
+	}
+	gboolean cached = TRUE;
+	g_mutex_lock(&aamp->mutex);
+	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+	{
+		media_stream* stream = &aamp->stream[i];
+		if (stream->srcpad && ((i != eMEDIATYPE_AUDIO) || aamp->audio_enabled)
+				&& !gst_aamp_cache_contains(stream->cache, (GstClockTime) position)
+				&& !(stream->timeshift && gst_aamp_timeshift_contains(stream->timeshift, (GstClockTime) position)))
+		{
+			cached = FALSE;
+			break;
+		}
+	}
+	g_mutex_unlock(&aamp->mutex);
+	return cached;
+}
+
 static gboolean gst_aamp_src_event(GstPad * pad, GstObject *parent, GstEvent * event)
 {
 	gboolean res = FALSE;
@@ -1319,18 +4581,37 @@ static gboolean gst_aamp_src_event(GstPad * pad, GstObject *parent, GstEvent * e
 			if (format == GST_FORMAT_TIME)
 			{
 				GST_INFO_OBJECT(aamp, "sink pad : seek GST_FORMAT_TIME: rate %f, pos %" G_GINT64_FORMAT "\n", rate, start );
+				gboolean cached = (flags & GST_SEEK_FLAG_FLUSH) && (start_type == GST_SEEK_TYPE_SET) && (rate == 1.0)
+						&& (aamp->rate == 1.0F) && gst_aamp_seek_cached(aamp, start);
 				if (flags & GST_SEEK_FLAG_FLUSH)
 				{
-					GST_DEBUG_OBJECT(aamp, "flush start");
-					gst_pad_push_event(aamp->stream[eMEDIATYPE_VIDEO].srcpad, gst_event_new_flush_start());
-					GST_DEBUG_OBJECT(aamp, "flush stop");
-					gst_pad_push_event(aamp->stream[eMEDIATYPE_VIDEO].srcpad, gst_event_new_flush_stop(TRUE));
+					g_mutex_lock(&aamp->mutex);
+					for (int i = 0; i < AAMP_TRACK_COUNT; i++)
+					{
+						gst_aamp_inflight_clear(&aamp->stream[i]);
+						/* Set before the flush, the player flushes again on seek unless the pad
+						 * stays clean until then */
+						if ((start_type == GST_SEEK_TYPE_SET) && !cached)
+						{
+							g_atomic_int_set(&aamp->stream[i].seekFlushed,
+									(i != eMEDIATYPE_AUDIO) || aamp->audio_enabled);
+						}
+					}
+					g_cond_broadcast(&aamp->budget_changed);
+					g_mutex_unlock(&aamp->mutex);
+					GstClockTime replayPosition = GST_CLOCK_TIME_NONE;
+					if (cached)
+					{
+						GST_INFO_OBJECT(aamp, "Serving seek to %" GST_TIME_FORMAT " from the seek cache", GST_TIME_ARGS(start));
+						g_atomic_int_set(&aamp->local_seek, 1);
+						replayPosition = (GstClockTime) start;
+					}
+					GST_DEBUG_OBJECT(aamp, "flush");
+					gst_aamp_src_seek_flush(aamp, &aamp->stream[eMEDIATYPE_VIDEO], replayPosition);
 					if (aamp->audio_enabled)
 					{
-						GST_DEBUG_OBJECT(aamp, "flush start - aud");
-						gst_pad_push_event(aamp->stream[eMEDIATYPE_AUDIO].srcpad, gst_event_new_flush_start());
-						GST_DEBUG_OBJECT(aamp, "flush stop -aud");
-						gst_pad_push_event(aamp->stream[eMEDIATYPE_AUDIO].srcpad, gst_event_new_flush_stop(TRUE));
+						GST_DEBUG_OBJECT(aamp, "flush - aud");
+						gst_aamp_src_seek_flush(aamp, &aamp->stream[eMEDIATYPE_AUDIO], replayPosition);
 					}
 				}
 				if (rate != aamp->rate)
@@ -1354,7 +4635,11 @@ static gboolean gst_aamp_src_event(GstPad * pad, GstObject *parent, GstEvent * e
 					{
 						pos = start / GST_SECOND;
 					}
-					aamp->player_aamp->SetRateAndSeek(rate, pos);
+					/* A seek served from the seek cache is replaying since the flush */
+					if (!cached)
+					{
+						aamp->player_aamp->SetRateAndSeek(rate, pos);
+					}
 				}
 				else
 				{
@@ -33,6 +33,9 @@ typedef struct _GstAamp GstAamp;
 typedef struct _GstAampClass GstAampClass;
 
 struct GstAampStreamer;
+struct GstAampRing;
+struct _GstAampCache;
+struct _GstAampTimeshift;
 class PlayerInstanceAAMP;
 
 enum _GstAampState {
@@ -46,14 +49,76 @@ enum _GstAampState {
 
 typedef enum _GstAampState GstAampState;
 
+/* Points of a tune that are timestamped for the tune time breakdown */
+enum _GstAampTuneMilestone {
+	GST_AAMP_TUNE_START,
+	GST_AAMP_TUNE_CALLED,
+	GST_AAMP_TUNE_CONFIGURED,
+	GST_AAMP_TUNE_PADS_EXPOSED,
+	GST_AAMP_TUNE_FIRST_VIDEO_BUFFER,
+	GST_AAMP_TUNE_FIRST_AUDIO_BUFFER,
+	GST_AAMP_TUNE_DISCONT_CLEARED,
+	GST_AAMP_TUNE_PLAYING,
+	GST_AAMP_TUNE_MILESTONE_COUNT
+};
+
+typedef enum _GstAampTuneMilestone GstAampTuneMilestone;
+
+/* Called once downstream no longer references a fragment passed to the raw
+ * StreamSink::Send(); ptr is the pointer given to Send(). */
+typedef void (*GstAampBufferReleaseFunc)(const void *ptr, gpointer user_data);
+
+/* Push statistics of a src pad. The counts are atomics. The 64-bit values are written by
+ * whichever thread pushes on the pad, fetcher, worker or pad task, and are only accessed
+ * under lock. */
+struct GstAampPadStats
+{
+	GMutex lock;
+	gint buffers;
+	gint fragments;
+	gint discontinuities;
+	gint flushes;
+	gint flowNotLinked;
+	gint flowFlushing;
+	gint flowEos;
+	gint flowNotNegotiated;
+	gint flowError;
+	guint64 bytes;
+	guint64 blockedTime;
+	GstClockTime lastPts;
+};
+
 struct media_stream
 {
 	GstPad *srcpad;
-	gboolean flush;
-	gboolean resetPosition;
-	gboolean streamStart;
-	gboolean eventsPending;
+	guint pendingEvents;
+	gint seekFlushed;
 	GstCaps *caps;
+	gint format;
+	GstBufferPool *pool;
+	gsize poolBufferSize;
+	gint poolHits;
+	gint poolMisses;
+	GstAllocator *allocator;
+	GstAllocationParams allocParams;
+	GstAampRing *ring;
+	GQueue inflight;
+	guint64 inflightBytes;
+	GstClockTime segmentStart;
+	guint32 timescale;
+	gboolean randomAccessSeen;
+	GstClockTime pushedTime;
+	struct _GstAampCache *cache;
+	GstClockTime replayPosition;
+	GstAampPadStats stats;
+	struct _GstAampTimeshift *timeshift;
+	guint64 timeshiftSeq;
+	gboolean timeshiftEos;
+	guint padSerial;
+	GMutex sendMutex;
+	GThread *worker;
+	gboolean workPending;
+	gint eos;
 };
 
 struct _GstAamp
@@ -69,8 +134,38 @@ struct _GstAamp
 	GCond state_changed;
 	GstAampState state;
 	gchar* stream_id;
-	guint idle_id;
+	GstBus *tune_bus;
+	gulong tune_handler;
+	gint tune_pending;
+	gint retune_pending;
+	GstElement *tune_pipeline;
 	gboolean report_tune;
+	GstAampBufferReleaseFunc release_func;
+	gpointer release_data;
+	gboolean push_buffer_list;
+	guint chunk_size;
+	gboolean async_push;
+	guint ring_depth;
+	guint64 max_inflight_bytes;
+	GstClockTime max_inflight_time;
+	gboolean split_access_units;
+	GstClockTime interleave_window;
+	GstClockTime seek_cache_time;
+	guint64 seek_cache_bytes;
+	guint64 timeshift_size;
+	gchar *timeshift_location;
+	gint timeshift_pending;
+	gboolean keep_audio_pad;
+	gint audio_gap;
+	guint64 startup_queue_bytes;
+	gboolean standby;
+	gint64 tune_times[GST_AAMP_TUNE_MILESTONE_COUNT];
+	guint tune_marked;
+	GstStructure *tune_stats;
+	gint local_seek;
+	gint position_query_busy;
+	GCond budget_changed;
+	GCond work_changed;
 
 #ifdef AAMP_CC_ENABLED
 	GThread *cc_handler_id;
@@ -84,6 +179,12 @@ struct _GstAamp
 struct _GstAampClass
 {
 	GstElementClass base_aamp_class;
+
+	/* action signals */
+	void (*set_buffer_release_func)(GstAamp *aamp, gpointer func, gpointer user_data);
+	void (*standby_add)(GstAamp *aamp, const gchar *uri);
+	void (*standby_remove)(GstAamp *aamp, const gchar *uri);
+	void (*standby_set_size)(GstAamp *aamp, guint size);
 };
 
 GType gst_aamp_get_type(void);
@@ -0,0 +1,166 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include "gstaampcache.h"
+
+/* Largest gap between the end of the cache and the next fragment that still counts as
+ * contiguous, fragment timestamps from the player are rounded */
+#define AAMP_CACHE_GAP_TOLERANCE (500 * GST_MSECOND)
+
+typedef struct
+{
+	GPtrArray *buffers;
+	GstClockTime pts;
+	GstClockTime end;
+	gsize bytes;
+} GstAampCacheEntry;
+
+struct _GstAampCache
+{
+	GMutex mutex;
+	GQueue entries;
+	guint64 bytes;
+};
+
+static void gst_aamp_cache_entry_free(GstAampCacheEntry *entry)
+{
+	g_ptr_array_unref(entry->buffers);
+	g_slice_free(GstAampCacheEntry, entry);
+}
+
+static void gst_aamp_cache_drop_head(GstAampCache *cache)
+{
+	GstAampCacheEntry *entry = (GstAampCacheEntry *) g_queue_pop_head(&cache->entries);
+	cache->bytes -= entry->bytes;
+	gst_aamp_cache_entry_free(entry);
+}
+
+GstAampCache* gst_aamp_cache_new(void)
+{
+	GstAampCache *cache = g_slice_new0(GstAampCache);
+	g_mutex_init(&cache->mutex);
+	g_queue_init(&cache->entries);
+	return cache;
+}
+
+void gst_aamp_cache_free(GstAampCache *cache)
+{
+	gst_aamp_cache_clear(cache);
+	g_mutex_clear(&cache->mutex);
+	g_slice_free(GstAampCache, cache);
+}
+
+void gst_aamp_cache_clear(GstAampCache *cache)
+{
+	g_mutex_lock(&cache->mutex);
+	while (!g_queue_is_empty(&cache->entries))
+	{
+		gst_aamp_cache_drop_head(cache);
+	}
+	g_mutex_unlock(&cache->mutex);
+}
+
+void gst_aamp_cache_add(GstAampCache *cache, GPtrArray *buffers, GstClockTime pts, GstClockTime end, gsize bytes,
+		GstClockTime maxTime, guint64 maxBytes)
+{
+	GstAampCacheEntry *entry = g_slice_new(GstAampCacheEntry);
+	entry->buffers = buffers;
+	entry->pts = pts;
+	entry->end = end;
+	entry->bytes = bytes;
+
+	g_mutex_lock(&cache->mutex);
+	GstAampCacheEntry *last = (GstAampCacheEntry *) g_queue_peek_tail(&cache->entries);
+	if (last && ((pts + AAMP_CACHE_GAP_TOLERANCE < last->end) || (pts > last->end + AAMP_CACHE_GAP_TOLERANCE)))
+	{
+		while (!g_queue_is_empty(&cache->entries))
+		{
+			gst_aamp_cache_drop_head(cache);
+		}
+	}
+	g_queue_push_tail(&cache->entries, entry);
+	cache->bytes += bytes;
+	while (g_queue_get_length(&cache->entries) > 1)
+	{
+		GstAampCacheEntry *first = (GstAampCacheEntry *) g_queue_peek_head(&cache->entries);
+		if ((maxBytes && cache->bytes > maxBytes) || (maxTime && (end - first->pts) > maxTime))
+		{
+			gst_aamp_cache_drop_head(cache);
+		}
+		else
+		{
+			break;
+		}
+	}
+	g_mutex_unlock(&cache->mutex);
+}
+
+/* Entry holding position, caller holds cache->mutex */
+static GList* gst_aamp_cache_find(GstAampCache *cache, GstClockTime position)
+{
+	for (GList *link = cache->entries.head; link; link = link->next)
+	{
+		GstAampCacheEntry *entry = (GstAampCacheEntry *) link->data;
+		if (position >= entry->pts && position < entry->end)
+		{
+			return link;
+		}
+	}
+	return NULL;
+}
+
+gboolean gst_aamp_cache_contains(GstAampCache *cache, GstClockTime position)
+{
+	g_mutex_lock(&cache->mutex);
+	gboolean found = (gst_aamp_cache_find(cache, position) != NULL);
+	g_mutex_unlock(&cache->mutex);
+	return found;
+}
+
+GPtrArray* gst_aamp_cache_lookup(GstAampCache *cache, GstClockTime position, GstClockTime *pts, GstClockTime *end,
+		gsize *bytes)
+{
+	GPtrArray *buffers = NULL;
+
+	g_mutex_lock(&cache->mutex);
+	GList *link = gst_aamp_cache_find(cache, position);
+	if (link)
+	{
+		buffers = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+		*pts = ((GstAampCacheEntry *) link->data)->pts;
+		*bytes = 0;
+		for (; link; link = link->next)
+		{
+			GstAampCacheEntry *entry = (GstAampCacheEntry *) link->data;
+			for (guint i = 0; i < entry->buffers->len; i++)
+			{
+				g_ptr_array_add(buffers, gst_buffer_ref((GstBuffer *) g_ptr_array_index(entry->buffers, i)));
+			}
+			*end = entry->end;
+			*bytes += entry->bytes;
+		}
+	}
+	g_mutex_unlock(&cache->mutex);
+	return buffers;
+}
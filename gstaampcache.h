@@ -0,0 +1,49 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GST_AAMP_CACHE_H_
+#define _GST_AAMP_CACHE_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Pushed fragments of one track kept for seeks back into them. The cache covers one
+ * contiguous stretch of media, a fragment that does not follow on restarts it. */
+typedef struct _GstAampCache GstAampCache;
+
+GstAampCache* gst_aamp_cache_new(void);
+void gst_aamp_cache_free(GstAampCache *cache);
+void gst_aamp_cache_clear(GstAampCache *cache);
+
+/* Add the buffers of a fragment spanning [pts, end), taking ownership of the array.
+ * The oldest fragments are dropped to stay within maxTime and maxBytes (0 = no limit). */
+void gst_aamp_cache_add(GstAampCache *cache, GPtrArray *buffers, GstClockTime pts, GstClockTime end, gsize bytes,
+		GstClockTime maxTime, guint64 maxBytes);
+
+gboolean gst_aamp_cache_contains(GstAampCache *cache, GstClockTime position);
+
+/* New references to the buffers from the fragment holding position to the end of the
+ * cache, NULL if position is not cached. pts, end and bytes describe what is returned. */
+GPtrArray* gst_aamp_cache_lookup(GstAampCache *cache, GstClockTime position, GstClockTime *pts, GstClockTime *end,
+		gsize *bytes);
+
+G_END_DECLS
+
+#endif
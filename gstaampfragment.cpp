@@ -0,0 +1,487 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include "gstaampfragment.h"
+
+gsize gst_aamp_isobmff_box_size(const guint8 *data, gsize len, guint32 *type)
+{
+	gsize headerSize = 8;
+	guint64 size;
+
+	if (len < headerSize)
+	{
+		return 0;
+	}
+	size = GST_READ_UINT32_BE(data);
+	*type = GST_READ_UINT32_BE(data + 4);
+	if (size == 1)
+	{
+		headerSize = 16;
+		if (len < headerSize)
+		{
+			return 0;
+		}
+		size = GST_READ_UINT64_BE(data + 8);
+	}
+	else if (size == 0)
+	{
+		/* Box extends to the end of the data */
+		size = len;
+	}
+	if ((size < headerSize) || (size > G_MAXSIZE))
+	{
+		return 0;
+	}
+	return (gsize) size;
+}
+
+gsize gst_aamp_isobmff_chunk_size(const guint8 *data, gsize len, gsize max)
+{
+	gsize offset = 0;
+
+	while (offset < len)
+	{
+		guint32 type = 0;
+		gsize size = gst_aamp_isobmff_box_size(data + offset, len - offset, &type);
+		if (size == 0 || size > len - offset)
+		{
+			return len;
+		}
+		if (max && offset > 0 && (offset + size) > max)
+		{
+			break;
+		}
+		offset += size;
+		if (!max && type == AAMP_FOURCC('m','d','a','t'))
+		{
+			break;
+		}
+	}
+	return offset;
+}
+
+#define AAMP_TS_TIMESTAMP_MASK ((G_GUINT64_CONSTANT(1) << 33) - 1)
+
+static gsize gst_aamp_isobmff_header_size(const guint8 *data)
+{
+	return (GST_READ_UINT32_BE(data) == 1) ? 16 : 8;
+}
+
+/* Find the first child box of a type among the boxes in data, returns its payload */
+static const guint8* gst_aamp_isobmff_find_box(const guint8 *data, gsize len, guint32 type, gsize *payloadLen)
+{
+	gsize offset = 0;
+
+	while (offset < len)
+	{
+		guint32 boxType = 0;
+		gsize size = gst_aamp_isobmff_box_size(data + offset, len - offset, &boxType);
+		if (size == 0 || size > len - offset)
+		{
+			break;
+		}
+		if (boxType == type)
+		{
+			gsize headerSize = gst_aamp_isobmff_header_size(data + offset);
+			*payloadLen = size - headerSize;
+			return data + offset + headerSize;
+		}
+		offset += size;
+	}
+	return NULL;
+}
+
+/* TRUE if a TS packet has the random_access_indicator of its adaptation field set */
+static gboolean gst_aamp_ts_random_access(const guint8 *packet)
+{
+	return (packet[3] & 0x20) && (packet[4] > 0) && (packet[5] & 0x40);
+}
+
+/* Position of the PES header starting in a TS packet, NULL if the packet starts none */
+static const guint8* gst_aamp_ts_pes_start(const guint8 *packet, guint *pid)
+{
+	gsize offset = 4;
+
+	if ((packet[0] != 0x47) || !(packet[1] & 0x40) || !(packet[3] & 0x10))
+	{
+		return NULL;
+	}
+	if (packet[3] & 0x20)
+	{
+		offset += 1 + packet[4];
+	}
+	/* Start code, stream id, length, flags and header length of the PES header */
+	if ((offset + 9 > AAMP_TS_PACKET_SIZE) || packet[offset] || packet[offset + 1] || (packet[offset + 2] != 1))
+	{
+		return NULL;
+	}
+	*pid = ((packet[1] & 0x1F) << 8) | packet[2];
+	return packet + offset;
+}
+
+static guint64 gst_aamp_ts_read_timestamp(const guint8 *data)
+{
+	return ((guint64) ((data[0] >> 1) & 0x07) << 30) | ((guint64) data[1] << 22) | ((guint64) (data[2] >> 1) << 15)
+			| ((guint64) data[3] << 7) | (data[4] >> 1);
+}
+
+/* Difference of two 90 kHz timestamps in nanoseconds, allowing for the 33 bit wrap */
+static GstClockTimeDiff gst_aamp_ts_timestamp_diff(guint64 ts, guint64 base)
+{
+	gint64 delta = (gint64) ((ts - base) & AAMP_TS_TIMESTAMP_MASK);
+	if (delta >= (gint64) (G_GUINT64_CONSTANT(1) << 32))
+	{
+		delta -= (gint64) (G_GUINT64_CONSTANT(1) << 33);
+	}
+	return (delta * 100000) / 9;
+}
+
+gboolean gst_aamp_ts_find_access_units(const guint8 *data, gsize len, GArray *aus)
+{
+	guint firstPid = G_MAXUINT;
+	guint videoPid = G_MAXUINT;
+	guint pid;
+	gsize offset;
+
+	for (offset = 0; (offset + AAMP_TS_PACKET_SIZE) <= len; offset += AAMP_TS_PACKET_SIZE)
+	{
+		const guint8 *pes = gst_aamp_ts_pes_start(data + offset, &pid);
+		if (data[offset] != 0x47)
+		{
+			return FALSE;
+		}
+		if (pes)
+		{
+			if (firstPid == G_MAXUINT)
+			{
+				firstPid = pid;
+			}
+			if (pes[3] >= 0xE0 && pes[3] <= 0xEF)
+			{
+				videoPid = pid;
+				break;
+			}
+		}
+	}
+	if (videoPid != G_MAXUINT)
+	{
+		firstPid = videoPid;
+	}
+	if (firstPid == G_MAXUINT)
+	{
+		return FALSE;
+	}
+
+	guint64 basePts = 0;
+	guint64 baseDts = 0;
+	guint start = aus->len;
+	for (offset = 0; (offset + AAMP_TS_PACKET_SIZE) <= len; offset += AAMP_TS_PACKET_SIZE)
+	{
+		const guint8 *pes = gst_aamp_ts_pes_start(data + offset, &pid);
+		if (!pes || (pid != firstPid))
+		{
+			continue;
+		}
+		guint ptsDtsFlags = pes[7] >> 6;
+		gsize headerEnd = (pes - (data + offset)) + 9 + ((ptsDtsFlags == 3) ? 10 : 5);
+		if (!(ptsDtsFlags & 0x2) || (headerEnd > AAMP_TS_PACKET_SIZE))
+		{
+			/* No usable PTS, the PES stays part of the previous access unit */
+			continue;
+		}
+		guint64 pts = gst_aamp_ts_read_timestamp(pes + 9);
+		guint64 dts = (ptsDtsFlags == 3) ? gst_aamp_ts_read_timestamp(pes + 14) : pts;
+		if (aus->len == start)
+		{
+			basePts = pts;
+			baseDts = dts;
+		}
+		GstAampAccessUnit au;
+		au.offset = offset;
+		au.pts = gst_aamp_ts_timestamp_diff(pts, basePts);
+		au.dts = gst_aamp_ts_timestamp_diff(dts, baseDts);
+		au.sync = gst_aamp_ts_random_access(data + offset);
+		g_array_append_val(aus, au);
+	}
+	return (aus->len > start);
+}
+
+guint32 gst_aamp_isobmff_find_timescale(const guint8 *data, gsize len)
+{
+	gsize boxLen = 0;
+	const guint8 *box = gst_aamp_isobmff_find_box(data, len, AAMP_FOURCC('m','o','o','v'), &boxLen);
+	if (box)
+	{
+		box = gst_aamp_isobmff_find_box(box, boxLen, AAMP_FOURCC('t','r','a','k'), &boxLen);
+	}
+	if (box)
+	{
+		box = gst_aamp_isobmff_find_box(box, boxLen, AAMP_FOURCC('m','d','i','a'), &boxLen);
+	}
+	if (box)
+	{
+		box = gst_aamp_isobmff_find_box(box, boxLen, AAMP_FOURCC('m','d','h','d'), &boxLen);
+	}
+	if (box && boxLen >= 4)
+	{
+		/* Version 1 has 64 bit creation and modification times */
+		gsize offset = (box[0] == 1) ? 20 : 12;
+		if (boxLen >= offset + 4)
+		{
+			return GST_READ_UINT32_BE(box + offset);
+		}
+	}
+	return 0;
+}
+
+/* Sample defaults carried in a tfhd box */
+typedef struct
+{
+	guint32 duration;
+	guint32 size;
+	guint32 flags;
+	gboolean hasFlags;
+} GstAampSampleDefaults;
+
+/* sample_is_non_sync_sample of the ISO BMFF sample flags */
+#define AAMP_ISOBMFF_SAMPLE_NON_SYNC 0x00010000
+
+static gboolean gst_aamp_isobmff_parse_tfhd(const guint8 *box, gsize len, GstAampSampleDefaults *defaults)
+{
+	gsize offset = 8;
+	guint32 flags;
+
+	if (len < offset)
+	{
+		return FALSE;
+	}
+	flags = GST_READ_UINT32_BE(box) & 0xFFFFFF;
+	if (flags & 0x1)
+	{
+		/* Absolute base data offsets cannot be mapped into the fragment */
+		return FALSE;
+	}
+	if (flags & 0x2)
+	{
+		offset += 4;
+	}
+	if (flags & 0x8)
+	{
+		if (len < offset + 4)
+		{
+			return FALSE;
+		}
+		defaults->duration = GST_READ_UINT32_BE(box + offset);
+		offset += 4;
+	}
+	if (flags & 0x10)
+	{
+		if (len < offset + 4)
+		{
+			return FALSE;
+		}
+		defaults->size = GST_READ_UINT32_BE(box + offset);
+		offset += 4;
+	}
+	if (flags & 0x20)
+	{
+		if (len < offset + 4)
+		{
+			return FALSE;
+		}
+		defaults->flags = GST_READ_UINT32_BE(box + offset);
+		defaults->hasFlags = TRUE;
+	}
+	return TRUE;
+}
+
+gboolean gst_aamp_isobmff_find_access_units(const guint8 *data, gsize len, guint32 timescale, GArray *aus)
+{
+	gsize moofOffset = 0;
+	guint start = aus->len;
+	gint64 firstPts = 0;
+	gint64 firstDts = 0;
+	gint64 nextDts = 0;
+	gsize lastOffset = 0;
+
+	while (moofOffset < len)
+	{
+		guint32 type = 0;
+		gsize size = gst_aamp_isobmff_box_size(data + moofOffset, len - moofOffset, &type);
+		if (size == 0 || size > len - moofOffset)
+		{
+			break;
+		}
+		if (type != AAMP_FOURCC('m','o','o','f'))
+		{
+			moofOffset += size;
+			continue;
+		}
+
+		gsize headerSize = gst_aamp_isobmff_header_size(data + moofOffset);
+		gsize trafLen = 0;
+		const guint8 *traf = gst_aamp_isobmff_find_box(data + moofOffset + headerSize, size - headerSize,
+				AAMP_FOURCC('t','r','a','f'), &trafLen);
+		gsize tfhdLen = 0;
+		const guint8 *tfhd = traf ? gst_aamp_isobmff_find_box(traf, trafLen, AAMP_FOURCC('t','f','h','d'), &tfhdLen) : NULL;
+		GstAampSampleDefaults defaults = { 0, 0, 0, FALSE };
+		if (!tfhd || !gst_aamp_isobmff_parse_tfhd(tfhd, tfhdLen, &defaults))
+		{
+			return FALSE;
+		}
+		gsize tfdtLen = 0;
+		const guint8 *tfdt = gst_aamp_isobmff_find_box(traf, trafLen, AAMP_FOURCC('t','f','d','t'), &tfdtLen);
+		gint64 dts = nextDts;
+		if (tfdt && tfdtLen >= 8)
+		{
+			dts = (tfdt[0] == 1 && tfdtLen >= 12) ? (gint64) GST_READ_UINT64_BE(tfdt + 4) : (gint64) GST_READ_UINT32_BE(tfdt + 4);
+		}
+
+		gsize dataOffset = moofOffset + size + 8;
+		gboolean firstInMoof = TRUE;
+		gsize trafOffset = 0;
+		while (trafOffset < trafLen)
+		{
+			guint32 childType = 0;
+			gsize childSize = gst_aamp_isobmff_box_size(traf + trafOffset, trafLen - trafOffset, &childType);
+			if (childSize == 0 || childSize > trafLen - trafOffset)
+			{
+				break;
+			}
+			if (childType == AAMP_FOURCC('t','r','u','n'))
+			{
+				gsize childHeader = gst_aamp_isobmff_header_size(traf + trafOffset);
+				const guint8 *trun = traf + trafOffset + childHeader;
+				gsize trunLen = childSize - childHeader;
+				if (trunLen < 8)
+				{
+					return FALSE;
+				}
+				guint32 version = trun[0];
+				guint32 flags = GST_READ_UINT32_BE(trun) & 0xFFFFFF;
+				guint32 sampleCount = GST_READ_UINT32_BE(trun + 4);
+				gsize offset = 8;
+				if (flags & 0x1)
+				{
+					if (trunLen < offset + 4)
+					{
+						return FALSE;
+					}
+					gint64 trunOffset = (gint64) moofOffset + (gint32) GST_READ_UINT32_BE(trun + offset);
+					if ((trunOffset < 0) || ((guint64) trunOffset > len))
+					{
+						return FALSE;
+					}
+					dataOffset = (gsize) trunOffset;
+					offset += 4;
+				}
+				guint32 firstSampleFlags = 0;
+				if (flags & 0x4)
+				{
+					if (trunLen < offset + 4)
+					{
+						return FALSE;
+					}
+					firstSampleFlags = GST_READ_UINT32_BE(trun + offset);
+					offset += 4;
+				}
+				gsize entrySize = ((flags & 0x100) ? 4 : 0) + ((flags & 0x200) ? 4 : 0) + ((flags & 0x400) ? 4 : 0)
+						+ ((flags & 0x800) ? 4 : 0);
+				if (trunLen < offset + (gsize) sampleCount * entrySize)
+				{
+					return FALSE;
+				}
+				for (guint32 i = 0; i < sampleCount; i++)
+				{
+					guint32 duration = defaults.duration;
+					guint32 sampleSize = defaults.size;
+					guint32 sampleFlags = defaults.flags;
+					gboolean hasFlags = defaults.hasFlags;
+					gint64 cto = 0;
+					if ((i == 0) && (flags & 0x4))
+					{
+						sampleFlags = firstSampleFlags;
+						hasFlags = TRUE;
+					}
+					if (flags & 0x100)
+					{
+						duration = GST_READ_UINT32_BE(trun + offset);
+						offset += 4;
+					}
+					if (flags & 0x200)
+					{
+						sampleSize = GST_READ_UINT32_BE(trun + offset);
+						offset += 4;
+					}
+					if (flags & 0x400)
+					{
+						sampleFlags = GST_READ_UINT32_BE(trun + offset);
+						hasFlags = TRUE;
+						offset += 4;
+					}
+					if (flags & 0x800)
+					{
+						guint32 value = GST_READ_UINT32_BE(trun + offset);
+						cto = version ? (gint64) (gint32) value : (gint64) value;
+						offset += 4;
+					}
+					if (dataOffset >= len)
+					{
+						break;
+					}
+					if (sampleSize == 0)
+					{
+						/* Nothing to push, only its duration counts */
+						dts += duration;
+						continue;
+					}
+					if (aus->len == start)
+					{
+						firstDts = dts;
+						firstPts = dts + cto;
+					}
+					GstAampAccessUnit au;
+					au.offset = firstInMoof ? moofOffset : dataOffset;
+					if ((aus->len > start) && (au.offset <= lastOffset))
+					{
+						/* Samples out of order, the offsets cannot delimit them */
+						return FALSE;
+					}
+					lastOffset = au.offset;
+					au.dts = timescale ? (GstClockTimeDiff) ((dts - firstDts) * (gint64) GST_SECOND / timescale) : 0;
+					au.pts = timescale ? (GstClockTimeDiff) ((dts + cto - firstPts) * (gint64) GST_SECOND / timescale) : 0;
+					au.sync = !hasFlags || !(sampleFlags & AAMP_ISOBMFF_SAMPLE_NON_SYNC);
+					g_array_append_val(aus, au);
+					firstInMoof = FALSE;
+					dts += duration;
+					dataOffset += sampleSize;
+				}
+			}
+			trafOffset += childSize;
+		}
+		nextDts = dts;
+		moofOffset += size;
+	}
+	return (aus->len > start);
+}
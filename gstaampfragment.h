@@ -0,0 +1,68 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GST_AAMP_FRAGMENT_H_
+#define _GST_AAMP_FRAGMENT_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define AAMP_TS_PACKET_SIZE 188
+
+#define AAMP_FOURCC(a,b,c,d) ((guint32)(((guint32)(a) << 24) | ((guint32)(b) << 16) | ((guint32)(c) << 8) | (guint32)(d)))
+
+/* Size of the ISO BMFF box at data and its type, 0 if the box header is invalid or the
+ * size does not fit a gsize */
+gsize gst_aamp_isobmff_box_size(const guint8 *data, gsize len, guint32 *type);
+
+/* Length of the leading whole top-level boxes of an ISO BMFF fragment. With max 0 the
+ * run ends after the first mdat, otherwise boxes are grouped up to max bytes. A box
+ * is never split, the remainder is returned as is if the box layout is invalid. */
+gsize gst_aamp_isobmff_chunk_size(const guint8 *data, gsize len, gsize max);
+
+/* An access unit found in a fragment. Timestamps are relative to the first access
+ * unit of the fragment, in nanoseconds. sync is set for random access points. */
+typedef struct
+{
+	gsize offset;
+	GstClockTimeDiff pts;
+	GstClockTimeDiff dts;
+	gboolean sync;
+} GstAampAccessUnit;
+
+/* Append the PES starts of the main elementary stream of an MPEG-TS fragment to aus,
+ * an array of GstAampAccessUnit. The first video PID is used, or the first PID
+ * carrying PES when there is no video. An access unit is a sync point when its first
+ * packet has the random_access_indicator set. Returns FALSE if nothing could be found. */
+gboolean gst_aamp_ts_find_access_units(const guint8 *data, gsize len, GArray *aus);
+
+/* Media timescale of the first track of a moov box in data, 0 if there is none */
+guint32 gst_aamp_isobmff_find_timescale(const guint8 *data, gsize len);
+
+/* Append the samples described by the moof boxes of an ISO BMFF fragment to aus. The
+ * first sample of each moof starts at the moof box so the box goes with its samples.
+ * Timestamps are 0 when timescale is 0. Samples without flags count as sync samples,
+ * empty samples are skipped. Returns FALSE if the sample data offsets are not increasing
+ * or point outside data. */
+gboolean gst_aamp_isobmff_find_access_units(const guint8 *data, gsize len, guint32 timescale, GArray *aus);
+
+G_END_DECLS
+
+#endif
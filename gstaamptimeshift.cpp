@@ -0,0 +1,242 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* fallocate() */
+#endif
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "gstaamptimeshift.h"
+
+/* Same as the seek cache, fragment timestamps from the player are rounded */
+#define AAMP_TIMESHIFT_GAP_TOLERANCE (500 * GST_MSECOND)
+
+typedef struct
+{
+	gsize offset;
+	gsize len;
+	guint64 seq;
+	GstClockTime pts;
+	GstClockTime dts;
+	GstClockTime end;
+} GstAampTimeshiftEntry;
+
+struct _GstAampTimeshift
+{
+	GMutex mutex;
+	gint fd;
+	guint8 *data;
+	gsize size;
+	gsize writeOffset;
+	guint64 nextSeq;
+	GQueue entries;
+};
+
+GstAampTimeshift* gst_aamp_timeshift_new(const gchar *directory, gsize size)
+{
+	/* The temporary directory is often a tmpfs, the file would then take RAM */
+	if (!directory)
+	{
+		directory = g_get_user_cache_dir();
+		g_mkdir_with_parents(directory, 0700);
+	}
+	gchar *path = g_build_filename(directory, "aamp-timeshift-XXXXXX", NULL);
+	gint fd = g_mkstemp(path);
+	guint8 *data = NULL;
+
+	if (fd < 0)
+	{
+		g_free(path);
+		return NULL;
+	}
+	/* The file only lives as long as the mapping */
+	unlink(path);
+	g_free(path);
+	/* Not a sparse file, writing a page the file system has no room for would raise SIGBUS.
+	 * Unlike posix_fallocate() this fails on file systems without support instead of zero-filling */
+	if (fallocate(fd, 0, 0, (off_t) size) == 0)
+	{
+		data = (guint8 *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if (!data || data == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	GstAampTimeshift *timeshift = g_slice_new0(GstAampTimeshift);
+	g_mutex_init(&timeshift->mutex);
+	g_queue_init(&timeshift->entries);
+	timeshift->fd = fd;
+	timeshift->data = data;
+	timeshift->size = size;
+	return timeshift;
+}
+
+static void gst_aamp_timeshift_drop_all(GstAampTimeshift *timeshift)
+{
+	GstAampTimeshiftEntry *entry;
+	while ((entry = (GstAampTimeshiftEntry *) g_queue_pop_head(&timeshift->entries)) != NULL)
+	{
+		g_slice_free(GstAampTimeshiftEntry, entry);
+	}
+	timeshift->writeOffset = 0;
+}
+
+void gst_aamp_timeshift_free(GstAampTimeshift *timeshift)
+{
+	gst_aamp_timeshift_drop_all(timeshift);
+	munmap(timeshift->data, timeshift->size);
+	close(timeshift->fd);
+	g_mutex_clear(&timeshift->mutex);
+	g_slice_free(GstAampTimeshift, timeshift);
+}
+
+void gst_aamp_timeshift_clear(GstAampTimeshift *timeshift)
+{
+	g_mutex_lock(&timeshift->mutex);
+	gst_aamp_timeshift_drop_all(timeshift);
+	g_mutex_unlock(&timeshift->mutex);
+}
+
+/**
+ * @brief Index a fragment and return where its bytes go, caller holds the mutex
+ *
+ * Fragments are never split across the end of the file, the writer wraps to the start
+ * and drops the oldest fragments the new one overlaps.
+ */
+static guint8* gst_aamp_timeshift_reserve(GstAampTimeshift *timeshift, gsize len, GstClockTime pts, GstClockTime dts,
+		GstClockTime end)
+{
+	if (len == 0 || len > timeshift->size)
+	{
+		gst_aamp_timeshift_drop_all(timeshift);
+		return NULL;
+	}
+	GstAampTimeshiftEntry *last = (GstAampTimeshiftEntry *) g_queue_peek_tail(&timeshift->entries);
+	if (last && ((pts + AAMP_TIMESHIFT_GAP_TOLERANCE < last->end) || (pts > last->end + AAMP_TIMESHIFT_GAP_TOLERANCE)))
+	{
+		gst_aamp_timeshift_drop_all(timeshift);
+	}
+	if (timeshift->writeOffset + len > timeshift->size)
+	{
+		timeshift->writeOffset = 0;
+	}
+	gsize start = timeshift->writeOffset;
+	GstAampTimeshiftEntry *oldest;
+	while ((oldest = (GstAampTimeshiftEntry *) g_queue_peek_head(&timeshift->entries)) != NULL
+			&& (oldest->offset < start + len) && (oldest->offset + oldest->len > start))
+	{
+		g_queue_pop_head(&timeshift->entries);
+		g_slice_free(GstAampTimeshiftEntry, oldest);
+	}
+
+	GstAampTimeshiftEntry *entry = g_slice_new(GstAampTimeshiftEntry);
+	entry->offset = start;
+	entry->len = len;
+	entry->seq = timeshift->nextSeq++;
+	entry->pts = pts;
+	entry->dts = dts;
+	entry->end = end;
+	g_queue_push_tail(&timeshift->entries, entry);
+	timeshift->writeOffset = start + len;
+	return timeshift->data + start;
+}
+
+gboolean gst_aamp_timeshift_write(GstAampTimeshift *timeshift, const void *data, gsize len, GstClockTime pts,
+		GstClockTime dts, GstClockTime end)
+{
+	g_mutex_lock(&timeshift->mutex);
+	guint8 *dest = gst_aamp_timeshift_reserve(timeshift, len, pts, dts, end);
+	if (dest)
+	{
+		memcpy(dest, data, len);
+	}
+	g_mutex_unlock(&timeshift->mutex);
+	return (dest != NULL);
+}
+
+/* Entry holding position or the first one after it, caller holds the mutex */
+static GstAampTimeshiftEntry* gst_aamp_timeshift_find(GstAampTimeshift *timeshift, GstClockTime position)
+{
+	for (GList *link = timeshift->entries.head; link; link = link->next)
+	{
+		GstAampTimeshiftEntry *entry = (GstAampTimeshiftEntry *) link->data;
+		if (position < entry->end)
+		{
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+gboolean gst_aamp_timeshift_contains(GstAampTimeshift *timeshift, GstClockTime position)
+{
+	g_mutex_lock(&timeshift->mutex);
+	GstAampTimeshiftEntry *entry = gst_aamp_timeshift_find(timeshift, position);
+	gboolean found = (entry && position >= entry->pts);
+	g_mutex_unlock(&timeshift->mutex);
+	return found;
+}
+
+gboolean gst_aamp_timeshift_seek(GstAampTimeshift *timeshift, GstClockTime position, guint64 *seq)
+{
+	g_mutex_lock(&timeshift->mutex);
+	GstAampTimeshiftEntry *entry = gst_aamp_timeshift_find(timeshift, position);
+	gboolean found = (entry && position >= entry->pts);
+	if (found)
+	{
+		*seq = entry->seq;
+	}
+	g_mutex_unlock(&timeshift->mutex);
+	return found;
+}
+
+gpointer gst_aamp_timeshift_read(GstAampTimeshift *timeshift, guint64 *seq, gsize *len, GstClockTime *pts,
+		GstClockTime *dts, GstClockTime *end)
+{
+	gpointer data = NULL;
+
+	g_mutex_lock(&timeshift->mutex);
+	for (GList *link = timeshift->entries.head; link; link = link->next)
+	{
+		GstAampTimeshiftEntry *entry = (GstAampTimeshiftEntry *) link->data;
+		if (entry->seq >= *seq)
+		{
+			/* A copy, the region can be overwritten as soon as the lock is dropped */
+			data = g_malloc(entry->len);
+			memcpy(data, timeshift->data + entry->offset, entry->len);
+			*seq = entry->seq;
+			*len = entry->len;
+			*pts = entry->pts;
+			*dts = entry->dts;
+			*end = entry->end;
+			break;
+		}
+	}
+	g_mutex_unlock(&timeshift->mutex);
+	return data;
+}
@@ -0,0 +1,56 @@
+/*
+* Copyright 2018 RDK Management
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Library General Public
+* License as published by the Free Software Foundation, version 2
+* of the license.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Library General Public License for more details.
+*
+* You should have received a copy of the GNU Library General Public
+* License along with this library; if not, write to the
+* Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+* Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _GST_AAMP_TIMESHIFT_H_
+#define _GST_AAMP_TIMESHIFT_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Fragments of one live track written to a size-capped memory-mapped file, indexed by
+ * PTS. The file is used as a ring, the oldest fragments are overwritten first. Like the
+ * seek cache it covers one contiguous stretch of media. Fragments are numbered in write
+ * order, a reader keeps the number of the next one it wants and so follows the writer
+ * across overwrites and clears. */
+typedef struct _GstAampTimeshift GstAampTimeshift;
+
+/* Create the file in directory, or the user cache directory when NULL, with all its
+ * blocks allocated. NULL on failure, including a file system without room for size. */
+GstAampTimeshift* gst_aamp_timeshift_new(const gchar *directory, gsize size);
+void gst_aamp_timeshift_free(GstAampTimeshift *timeshift);
+void gst_aamp_timeshift_clear(GstAampTimeshift *timeshift);
+
+/* Store a fragment spanning [pts, end) */
+gboolean gst_aamp_timeshift_write(GstAampTimeshift *timeshift, const void *data, gsize len, GstClockTime pts,
+		GstClockTime dts, GstClockTime end);
+
+gboolean gst_aamp_timeshift_contains(GstAampTimeshift *timeshift, GstClockTime position);
+
+/* Number of the fragment holding position, FALSE if position is not in the file */
+gboolean gst_aamp_timeshift_seek(GstAampTimeshift *timeshift, GstClockTime position, guint64 *seq);
+
+/* g_malloc() copy of the first fragment numbered *seq or later, with its number and
+ * timestamps. NULL once *seq is past the last fragment. */
+gpointer gst_aamp_timeshift_read(GstAampTimeshift *timeshift, guint64 *seq, gsize *len, GstClockTime *pts,
+		GstClockTime *dts, GstClockTime *end);
+
+G_END_DECLS
+
+#endif